@@ -1,7 +1,38 @@
+// The benchmarks rely on the compiler to vectorize the kernels, which GCC
+// (before version 13) does only at -O3, e.g.
+// g++ -std=c++23 -O3 -march=native concept.cc
+
 #include <array>
 #include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include <span>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <bit>
 #include <format>
 #include <iostream>
+#if __has_include(<experimental/simd>)
+#include <experimental/simd>
+#define USE_STD_SIMD 1
+namespace stdx = std::experimental;
+#else
+#define USE_STD_SIMD 0
+#endif
 
 // Numerical concepts to be used later...
 template <typename T>
@@ -31,8 +62,2092 @@ std::ostream &operator<<(std::ostream &stream, const Particle<idx_t, float_t, 2>
     return stream;
 }
 
+// Maximum exponent of the number of particles (10^BENCHMARK_MAX_EXP) in the
+// benchmarks. 10^8 particles need a few GB of memory per layout
+#ifndef BENCHMARK_MAX_EXP
+#define BENCHMARK_MAX_EXP 7
+#endif
+
+// Alignment of the arrays of a ParticleSystem: a cache line, which is also
+// the width of the widest (AVX-512) vector registers
+constexpr std::size_t simd_alignment = 64;
+
+// Allocator of memory aligned to Alignment bytes
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    // Required by: std::allocator_traits (which cannot rebind an allocator with a non-type template parameter)
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept
+    {
+        ::operator delete(ptr, n * sizeof(T), std::align_val_t{Alignment});
+    }
+
+    friend bool operator==(const AlignedAllocator &, const AlignedAllocator &) = default;
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, simd_alignment>>;
+
+// The ParticleSystem class stores particles as a structure of arrays (SoA),
+// i.e. each field of Particle in its own array, and each component of the
+// position and velocity vectors in its own array as well, instead of an
+// array of Particle structs (AoS), where the fields of each particle are
+// interleaved. Thus, a kernel streams through memory only the fields that it
+// uses, and consecutive values of a field can be loaded into a vector
+// register at once, so that the loops over the particles vectorize.
+// Indexing a ParticleSystem returns a proxy reference, whose members have
+// the names of those of Particle, so that a single particle can still be
+// accessed as if it were a Particle, and converted to or from one.
+template <idx_type idx_t,
+          float_type float_t,
+          std::size_t dim>
+class ParticleSystem
+{
+    using field_type = std::array<AlignedVector<float_t>, dim>;
+
+public:
+    using particle_type = Particle<idx_t, float_t, dim>;
+
+    // Proxy reference to the dim components of a vector of a particle (x_ or u_)
+    template <bool Const>
+    class VectorRef
+    {
+        using field_ref = std::conditional_t<Const, const field_type, field_type> &;
+
+    public:
+        VectorRef(field_ref field, std::size_t idx)
+            : field_(field), idx_(idx)
+        {
+        }
+
+        // Assigns the components, rather than rebinding the reference
+        const VectorRef &operator=(const VectorRef &other) const
+            requires(!Const)
+        {
+            return *this = std::array<float_t, dim>(other);
+        }
+
+        const VectorRef &operator=(const std::array<float_t, dim> &values) const
+            requires(!Const)
+        {
+            for (std::size_t d = 0; d < dim; d++)
+            {
+                field_[d][idx_] = values[d];
+            }
+            return *this;
+        }
+
+        auto &operator[](std::size_t d) const
+        {
+            return field_[d][idx_];
+        }
+
+        operator std::array<float_t, dim>() const
+        {
+            std::array<float_t, dim> values;
+            for (std::size_t d = 0; d < dim; d++)
+            {
+                values[d] = field_[d][idx_];
+            }
+            return values;
+        }
+
+        static constexpr std::size_t size()
+        {
+            return dim;
+        }
+
+    private:
+        field_ref field_;
+        std::size_t idx_;
+    };
+
+    // Proxy reference to a particle
+    template <bool Const>
+    struct ParticleRef
+    {
+        std::conditional_t<Const, const idx_t, idx_t> &id_;
+        std::conditional_t<Const, const float_t, float_t> &mass_;
+        VectorRef<Const> x_;
+        VectorRef<Const> u_;
+
+        const ParticleRef &operator=(const ParticleRef &other) const
+            requires(!Const)
+        {
+            return *this = particle_type(other);
+        }
+
+        const ParticleRef &operator=(const particle_type &particle) const
+            requires(!Const)
+        {
+            id_ = particle.id_;
+            mass_ = particle.mass_;
+            x_ = particle.x_;
+            u_ = particle.u_;
+            return *this;
+        }
+
+        operator particle_type() const
+        {
+            return {.id_ = id_, .mass_ = mass_, .x_ = x_, .u_ = u_};
+        }
+    };
+
+    using reference = ParticleRef<false>;
+    using const_reference = ParticleRef<true>;
+
+    // Iterates over the particles by index, yielding proxy references
+    template <bool Const>
+    class Iterator
+    {
+        using system_ref = std::conditional_t<Const, const ParticleSystem, ParticleSystem> &;
+
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = particle_type;
+
+        Iterator(system_ref system, std::size_t idx)
+            : system_(&system), idx_(idx)
+        {
+        }
+
+        ParticleRef<Const> operator*() const
+        {
+            return system_->get(idx_);
+        }
+
+        Iterator &operator++()
+        {
+            idx_++;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const Iterator &, const Iterator &) = default;
+
+    private:
+        std::remove_reference_t<system_ref> *system_;
+        std::size_t idx_;
+    };
+
+    ParticleSystem() = default;
+
+    explicit ParticleSystem(std::size_t size)
+    {
+        resize(size);
+    }
+
+    std::size_t size() const
+    {
+        return ids_.size();
+    }
+
+    void resize(std::size_t size)
+    {
+        ids_.resize(size);
+        masses_.resize(size);
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            x_[d].resize(size);
+            u_[d].resize(size);
+        }
+    }
+
+    void reserve(std::size_t capacity)
+    {
+        ids_.reserve(capacity);
+        masses_.reserve(capacity);
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            x_[d].reserve(capacity);
+            u_[d].reserve(capacity);
+        }
+    }
+
+    void push_back(const particle_type &particle)
+    {
+        ids_.push_back(particle.id_);
+        masses_.push_back(particle.mass_);
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            x_[d].push_back(particle.x_[d]);
+            u_[d].push_back(particle.u_[d]);
+        }
+    }
+
+    reference operator[](std::size_t idx)
+    {
+        check_index(idx);
+        return get(idx);
+    }
+
+    const_reference operator[](std::size_t idx) const
+    {
+        check_index(idx);
+        return get(idx);
+    }
+
+    Iterator<false> begin() { return {*this, 0}; }
+    Iterator<false> end() { return {*this, size()}; }
+    Iterator<true> begin() const { return {*this, 0}; }
+    Iterator<true> end() const { return {*this, size()}; }
+
+    // The arrays of the fields, for kernels that loop over the particles
+    std::span<idx_t> ids() { return ids_; }
+    std::span<const idx_t> ids() const { return ids_; }
+    std::span<float_t> masses() { return masses_; }
+    std::span<const float_t> masses() const { return masses_; }
+    std::span<float_t> x(std::size_t d) { return x_[d]; }
+    std::span<const float_t> x(std::size_t d) const { return x_[d]; }
+    std::span<float_t> u(std::size_t d) { return u_[d]; }
+    std::span<const float_t> u(std::size_t d) const { return u_[d]; }
+
+private:
+    void check_index(std::size_t idx) const
+    {
+        if (idx >= size())
+        {
+            throw std::range_error(std::format("Invalid index {} for ParticleSystem of size {}\n", idx, size()));
+        }
+    }
+
+    reference get(std::size_t idx)
+    {
+        return {ids_[idx], masses_[idx], {x_, idx}, {u_, idx}};
+    }
+
+    const_reference get(std::size_t idx) const
+    {
+        return {ids_[idx], masses_[idx], {x_, idx}, {u_, idx}};
+    }
+
+    AlignedVector<idx_t> ids_;
+    AlignedVector<float_t> masses_;
+    field_type x_;
+    field_type u_;
+};
+
+// The iterators work with the standard algorithms and ranges
+static_assert(std::input_iterator<decltype(std::declval<ParticleSystem<int, float, 3> &>().begin())>);
+static_assert(std::input_iterator<decltype(std::declval<const ParticleSystem<int, float, 3> &>().begin())>);
+
+// Kernels over the arrays of a ParticleSystem, which are aligned, and never
+// overlap. The latter is declared with __restrict, so that the compiler
+// vectorizes the loops without checking for overlap at runtime (which GCC
+// does not do at -O2).
+
+// x += a u
+template <float_type float_t>
+void drift(std::size_t n, float_t a, const float_t *__restrict u, float_t *__restrict x)
+{
+    u = std::assume_aligned<simd_alignment>(u);
+    x = std::assume_aligned<simd_alignment>(x);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        x[i] += a * u[i];
+    }
+}
+
+// u += a x / m
+template <float_type float_t>
+void kick_harmonic(std::size_t n, float_t a, const float_t *__restrict m, const float_t *__restrict x, float_t *__restrict u)
+{
+    m = std::assume_aligned<simd_alignment>(m);
+    x = std::assume_aligned<simd_alignment>(x);
+    u = std::assume_aligned<simd_alignment>(u);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        u[i] += a / m[i] * x[i];
+    }
+}
+
+// Compare the time per particle of two kernels, for n particles stored as an
+// array of Particle structs (AoS) and as a ParticleSystem (SoA):
+// drift, which advances the positions (x += u dt) and does not use the
+// masses, and kick, which advances the velocities under a harmonic force
+// (u += -k x / m dt). The kernels are repeated so that they process about
+// 10^8 particles in total, for any n.
+template <idx_type idx_t,
+          float_type float_t,
+          std::size_t dim>
+void benchmark_layouts(std::size_t n)
+{
+    using particle_type = Particle<idx_t, float_t, dim>;
+    constexpr float_t dt = 1e-3;
+    constexpr float_t k = 1;
+    const std::size_t n_repeats = std::max<std::size_t>(3, 100'000'000 / n);
+
+    auto time_per_particle = [n, n_repeats](auto kernel)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < n_repeats; r++)
+        {
+            kernel();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count() / (n * n_repeats);
+    };
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float_t> dist(-1, 1);
+    auto random_particle = [&](std::size_t i)
+    {
+        particle_type particle{.id_ = static_cast<idx_t>(i), .mass_ = 1 + dist(gen) / 2, .x_ = {}, .u_ = {}};
+        std::ranges::generate(particle.x_, [&]
+                              { return dist(gen); });
+        std::ranges::generate(particle.u_, [&]
+                              { return dist(gen); });
+        return particle;
+    };
+
+    double aos_drift_ns, aos_kick_ns;
+    float_t aos_x;
+    {
+        std::vector<particle_type> particles(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            particles[i] = random_particle(i);
+        }
+
+        aos_drift_ns = time_per_particle([&particles]
+                                         {
+                                             for (auto &particle : particles)
+                                             {
+                                                 for (std::size_t d = 0; d < dim; d++)
+                                                 {
+                                                     particle.x_[d] += particle.u_[d] * dt;
+                                                 }
+                                             } });
+        aos_kick_ns = time_per_particle([&particles]
+                                        {
+                                            for (auto &particle : particles)
+                                            {
+                                                const float_t c = -k / particle.mass_ * dt;
+                                                for (std::size_t d = 0; d < dim; d++)
+                                                {
+                                                    particle.u_[d] += c * particle.x_[d];
+                                                }
+                                            } });
+        aos_x = particles[n / 2].x_[0];
+    }
+
+    double soa_drift_ns, soa_kick_ns;
+    float_t soa_x;
+    {
+        gen.seed(42);
+        ParticleSystem<idx_t, float_t, dim> particles;
+        particles.reserve(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            particles.push_back(random_particle(i));
+        }
+
+        soa_drift_ns = time_per_particle([&particles]
+                                         {
+                                             for (std::size_t d = 0; d < dim; d++)
+                                             {
+                                                 drift(particles.size(), dt, particles.u(d).data(), particles.x(d).data());
+                                             } });
+        soa_kick_ns = time_per_particle([&particles]
+                                        {
+                                            for (std::size_t d = 0; d < dim; d++)
+                                            {
+                                                kick_harmonic(particles.size(), -k * dt, particles.masses().data(),
+                                                              particles.x(d).data(), particles.u(d).data());
+                                            } });
+        soa_x = particles[n / 2].x_[0];
+    }
+
+    std::cout << std::format("n: {:>9}, drift: AoS {:>6.3f} ns, SoA {:>6.3f} ns ({:.1f}x), kick: AoS {:>6.3f} ns, SoA {:>6.3f} ns ({:.1f}x){}\n",
+                             n, aos_drift_ns, soa_drift_ns, aos_drift_ns / soa_drift_ns,
+                             aos_kick_ns, soa_kick_ns, aos_kick_ns / soa_kick_ns,
+                             std::abs(aos_x - soa_x) <= 1e-3 * (1 + std::abs(aos_x)) ? "" : " (mismatch)");
+}
+
+// Number of hardware threads, queried once, since it reads a file (on Linux)
+inline std::size_t n_hardware_threads()
+{
+    static const std::size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+    return n_threads;
+}
+
+// Call f(chunk, first, last) for consecutive chunks of [0, n), at most one
+// per hardware thread, each in its own thread (the calling thread takes the
+// first chunk), and return the number of chunks. The chunks start at
+// multiples of align elements, so that they start at aligned addresses, and
+// do not share cache lines. The threads are started per call, which costs
+// some tens of microseconds, thus small ranges are processed by the calling
+// thread alone. The chunks are the same for the same n and align.
+template <typename F>
+std::size_t parallel_for_chunks(std::size_t n, std::size_t align, F f)
+{
+    constexpr std::size_t min_chunk_size = 16 * 1024;
+    const std::size_t chunk_size = std::max(min_chunk_size, ((n + n_hardware_threads() - 1) / n_hardware_threads() + align - 1) / align * align);
+    if (chunk_size >= n)
+    {
+        f(std::size_t{0}, std::size_t{0}, n);
+        return 1;
+    }
+
+    std::vector<std::jthread> threads;
+    std::size_t chunk = 1;
+    for (std::size_t first = chunk_size; first < n; first += chunk_size, chunk++)
+    {
+        threads.emplace_back(f, chunk, first, std::min(n, first + chunk_size));
+    }
+    f(std::size_t{0}, std::size_t{0}, chunk_size);
+    return chunk;
+}
+
+// Call f(first, last) for consecutive chunks of [0, n), in parallel
+template <typename F>
+void parallel_for(std::size_t n, std::size_t align, F f)
+{
+    parallel_for_chunks(n, align, [&f](std::size_t, std::size_t first, std::size_t last)
+                        { f(first, last); });
+}
+
+// Replace each value by the sum of the values before it, and return the sum
+// of all values. Each chunk is summed in parallel, then the sums of the chunks
+// are scanned, and finally each chunk is scanned in parallel, starting from the
+// sum of the chunks before it.
+template <typename T>
+T parallel_exclusive_scan(std::span<T> values)
+{
+    constexpr std::size_t align = simd_alignment / sizeof(T);
+    std::vector<T> partial(n_hardware_threads());
+    const std::size_t n_chunks = parallel_for_chunks(values.size(), align, [&](std::size_t chunk, std::size_t first, std::size_t last)
+                                                     { partial[chunk] = std::accumulate(values.begin() + first, values.begin() + last, T{0}); });
+    const T total = std::accumulate(partial.begin(), partial.begin() + n_chunks, T{0});
+    std::exclusive_scan(partial.begin(), partial.begin() + n_chunks, partial.begin(), T{0});
+    parallel_for_chunks(values.size(), align, [&](std::size_t chunk, std::size_t first, std::size_t last)
+                        { std::exclusive_scan(values.begin() + first, values.begin() + last, values.begin() + first, partial[chunk]); });
+    return total;
+}
+
+// Sort the keys, and the values along with them, with a least significant
+// digit radix sort, 8 bits per pass. Each pass counts the digits of the keys
+// of each chunk in parallel, turns the counts into the offset of each digit
+// of each chunk (the chunks of digit 0 first, then those of digit 1 etc.), and
+// moves the keys of each chunk to these offsets in parallel, which keeps the
+// sort stable. The passes over digits that are the same for all keys, e.g.
+// the high digits of small keys, are skipped.
+template <typename T>
+void parallel_radix_sort(std::span<std::uint64_t> keys, std::span<T> values)
+{
+    constexpr std::size_t radix_bits = 8;
+    constexpr std::size_t radix = std::size_t{1} << radix_bits;
+    const std::size_t n = keys.size();
+
+    std::vector<std::uint64_t> keys_buffer(n);
+    std::vector<T> values_buffer(n);
+    std::span<std::uint64_t> keys_from = keys;
+    std::span<std::uint64_t> keys_to = keys_buffer;
+    std::span<T> values_from = values;
+    std::span<T> values_to = values_buffer;
+
+    std::vector<std::array<std::size_t, radix>> offsets(n_hardware_threads());
+    for (std::size_t shift = 0; shift < 64; shift += radix_bits)
+    {
+        auto digit = [shift](std::uint64_t key)
+        {
+            return static_cast<std::size_t>(key >> shift) & (radix - 1);
+        };
+
+        const std::size_t n_chunks = parallel_for_chunks(n, 1, [&](std::size_t chunk, std::size_t first, std::size_t last)
+                                                         {
+                                                             offsets[chunk].fill(0);
+                                                             for (std::size_t i = first; i < last; i++)
+                                                             {
+                                                                 offsets[chunk][digit(keys_from[i])]++;
+                                                             } });
+
+        std::size_t offset = 0;
+        bool same_digit = false;
+        for (std::size_t d = 0; d < radix; d++)
+        {
+            const std::size_t first = offset;
+            for (std::size_t chunk = 0; chunk < n_chunks; chunk++)
+            {
+                offset += std::exchange(offsets[chunk][d], offset);
+            }
+            same_digit |= offset - first == n;
+        }
+        if (same_digit)
+        {
+            continue;
+        }
+
+        parallel_for_chunks(n, 1, [&](std::size_t chunk, std::size_t first, std::size_t last)
+                            {
+                                for (std::size_t i = first; i < last; i++)
+                                {
+                                    const std::size_t pos = offsets[chunk][digit(keys_from[i])]++;
+                                    keys_to[pos] = keys_from[i];
+                                    values_to[pos] = values_from[i];
+                                } });
+        std::swap(keys_from, keys_to);
+        std::swap(values_from, values_to);
+    }
+
+    if (keys_from.data() != keys.data())
+    {
+        std::ranges::copy(keys_from, keys.begin());
+        std::ranges::copy(values_from, values.begin());
+    }
+}
+
+// Time integrators, which advance the positions x and velocities u of the
+// particles by a time step dt, under accelerations a(x) that depend on
+// the position of each particle alone (an external field)
+// explicit_euler: x' = x + u dt, u' = u + a(x) dt (not symplectic, the
+// energy grows steadily)
+// symplectic_euler: u' = u + a(x) dt, x' = x + u' dt (1st order)
+// velocity_verlet: kick-drift-kick, u += a(x) dt/2, x += u dt, u += a(x) dt/2
+// (2nd order)
+// leapfrog: drift-kick-drift, x += u dt/2, u += a(x) dt, x += u dt/2
+// (2nd order)
+enum class Integrator
+{
+    explicit_euler,
+    symplectic_euler,
+    velocity_verlet,
+    leapfrog
+};
+
+constexpr std::string_view integrator_name(Integrator method)
+{
+    switch (method)
+    {
+    case Integrator::explicit_euler:
+        return "explicit Euler";
+    case Integrator::symplectic_euler:
+        return "symplectic Euler";
+    case Integrator::velocity_verlet:
+        return "velocity Verlet";
+    case Integrator::leapfrog:
+        return "leapfrog";
+    }
+    return "unknown";
+}
+
+// Advance the state of a particle by dt. V is either float_t, for a single
+// particle, or a SIMD vector of float_t, for as many particles as its width.
+// The acceleration is called as a(x, m), with x an array of dim V's
+template <Integrator method, typename V, std::size_t dim, float_type float_t, typename Acceleration>
+void advance(std::array<V, dim> &x, std::array<V, dim> &u, const V &m, float_t dt, const Acceleration &a)
+{
+    auto drift = [&x, &u](float_t h)
+    {
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            x[d] += u[d] * h;
+        }
+    };
+    auto kick = [&u](const std::array<V, dim> &acc, float_t h)
+    {
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            u[d] += acc[d] * h;
+        }
+    };
+
+    if constexpr (method == Integrator::explicit_euler)
+    {
+        const auto acc = a(x, m);
+        drift(dt);
+        kick(acc, dt);
+    }
+    else if constexpr (method == Integrator::symplectic_euler)
+    {
+        kick(a(x, m), dt);
+        drift(dt);
+    }
+    else if constexpr (method == Integrator::velocity_verlet)
+    {
+        kick(a(x, m), dt / 2);
+        drift(dt);
+        kick(a(x, m), dt / 2);
+    }
+    else
+    {
+        drift(dt / 2);
+        kick(a(x, m), dt);
+        drift(dt / 2);
+    }
+}
+
+// Advance all particles by one time step. Each thread processes a chunk of
+// the particles, SIMD vector by SIMD vector (std::experimental::simd, whose
+// width is that of the registers of the target, e.g. 8 floats with AVX2),
+// loaded from and stored to the aligned arrays of each field, and the last
+// few particles one by one.
+template <Integrator method, idx_type idx_t, float_type float_t, std::size_t dim, typename Acceleration>
+void integrate(ParticleSystem<idx_t, float_t, dim> &particles, float_t dt, const Acceleration &a)
+{
+    const float_t *m = particles.masses().data();
+    std::array<float_t *, dim> x;
+    std::array<float_t *, dim> u;
+    for (std::size_t d = 0; d < dim; d++)
+    {
+        x[d] = particles.x(d).data();
+        u[d] = particles.u(d).data();
+    }
+
+    parallel_for(particles.size(), simd_alignment / sizeof(float_t), [=, &a](std::size_t first, std::size_t last)
+                 {
+                     std::size_t i = first;
+#if (USE_STD_SIMD == 1)
+                     using V = stdx::native_simd<float_t>;
+                     for (; i + V::size() <= last; i += V::size())
+                     {
+                         std::array<V, dim> xv;
+                         std::array<V, dim> uv;
+                         const V mv(m + i, stdx::vector_aligned);
+                         for (std::size_t d = 0; d < dim; d++)
+                         {
+                             xv[d].copy_from(x[d] + i, stdx::vector_aligned);
+                             uv[d].copy_from(u[d] + i, stdx::vector_aligned);
+                         }
+                         advance<method>(xv, uv, mv, dt, a);
+                         for (std::size_t d = 0; d < dim; d++)
+                         {
+                             xv[d].copy_to(x[d] + i, stdx::vector_aligned);
+                             uv[d].copy_to(u[d] + i, stdx::vector_aligned);
+                         }
+                     }
+#endif
+                     for (; i < last; i++)
+                     {
+                         std::array<float_t, dim> xs;
+                         std::array<float_t, dim> us;
+                         for (std::size_t d = 0; d < dim; d++)
+                         {
+                             xs[d] = x[d][i];
+                             us[d] = u[d][i];
+                         }
+                         advance<method>(xs, us, m[i], dt, a);
+                         for (std::size_t d = 0; d < dim; d++)
+                         {
+                             x[d][i] = xs[d];
+                             u[d][i] = us[d];
+                         }
+                     } });
+}
+
+// Compare the throughput (particles per second) of each integrator, applied
+// to n particles in harmonic potentials (a = -k x / m), with a scalar loop
+// over an array of Particle structs, and with integrate() over a
+// ParticleSystem. Also shows the relative change of the total energy after
+// the steps, which is bounded for the symplectic integrators only.
+template <Integrator method, idx_type idx_t, float_type float_t, std::size_t dim>
+void benchmark_integrator(std::size_t n)
+{
+    using particle_type = Particle<idx_t, float_t, dim>;
+    constexpr float_t dt = 1e-2;
+    constexpr float_t k = 1;
+    const std::size_t n_steps = std::max<std::size_t>(10, 30'000'000 / n);
+
+    auto acceleration = [](const auto &x, const auto &m)
+    {
+        auto acc = x;
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            acc[d] = -k * x[d] / m;
+        }
+        return acc;
+    };
+
+    auto energy = [](float_t m, const auto &x, const auto &u)
+    {
+        double e = 0;
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            e += 0.5 * m * u[d] * u[d] + 0.5 * k * x[d] * x[d];
+        }
+        return e;
+    };
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float_t> dist(-1, 1);
+    std::vector<particle_type> aos(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        aos[i] = {.id_ = static_cast<idx_t>(i), .mass_ = 1 + dist(gen) / 2, .x_ = {}, .u_ = {}};
+        std::ranges::generate(aos[i].x_, [&]
+                              { return dist(gen); });
+        std::ranges::generate(aos[i].u_, [&]
+                              { return dist(gen); });
+    }
+    ParticleSystem<idx_t, float_t, dim> soa;
+    soa.reserve(n);
+    double initial_energy = 0;
+    for (const auto &particle : aos)
+    {
+        soa.push_back(particle);
+        initial_energy += energy(particle.mass_, particle.x_, particle.u_);
+    }
+
+    auto particles_per_second = [n, n_steps](auto step)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t s = 0; s < n_steps; s++)
+        {
+            step();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return n * n_steps / std::chrono::duration<double>(stop - start).count();
+    };
+
+    const double aos_rate = particles_per_second([&]
+                                                 {
+                                                     for (auto &particle : aos)
+                                                     {
+                                                         advance<method>(particle.x_, particle.u_, particle.mass_, dt, acceleration);
+                                                     } });
+    const double soa_rate = particles_per_second([&]
+                                                 { integrate<method>(soa, dt, acceleration); });
+
+    double final_energy = 0;
+    for (const auto &particle : soa)
+    {
+        final_energy += energy(particle.mass_, std::array<float_t, dim>(particle.x_), std::array<float_t, dim>(particle.u_));
+    }
+    const bool match = std::abs(aos[n / 2].x_[0] - soa[n / 2].x_[0]) <= 1e-3 * (1 + std::abs(aos[n / 2].x_[0]));
+
+    std::cout << std::format("  {:<17} scalar AoS: {:>8.1f} M/s, SIMD SoA: {:>8.1f} M/s ({:>4.1f}x), energy change after {:>5} steps: {:>9.2e}{}\n",
+                             integrator_name(method), aos_rate * 1e-6, soa_rate * 1e-6, soa_rate / aos_rate, n_steps,
+                             (final_energy - initial_energy) / initial_energy, match ? "" : " (mismatch)");
+}
+
+// The CellList class bins particles into a uniform grid of cells, whose sides
+// are not shorter than a cutoff radius, so that the particles within the
+// cutoff of a particle are in its cell or in the adjacent ones (3^dim cells
+// in total). Thus, finding the neighbors of all particles costs O(N), rather
+// than O(N^2), for a bounded density. The particles are binned by a counting
+// sort: the particles of each cell are counted, the counts are turned into
+// the offsets of the cells by a (parallel) prefix sum, and the indices of the
+// particles are stored at these offsets, i.e. sorted by cell.
+// The cells are numbered with the first dimension varying fastest, so that
+// the particles of a row of adjacent cells are contiguous.
+template <float_type float_t, std::size_t dim>
+class CellList
+{
+public:
+    // Bin the particles into cells with sides of at least cell_size
+    template <idx_type idx_t>
+    void build(const ParticleSystem<idx_t, float_t, dim> &particles, float_t cell_size)
+    {
+        const std::size_t n = particles.size();
+
+        // Cover the bounding box of the particles, with at most about 2 cells per
+        // particle (larger cells for sparse particles)
+        std::array<float_t, dim> extent{};
+        for (std::size_t d = 0; d < dim && n > 0; d++)
+        {
+            const auto [min, max] = std::ranges::minmax(particles.x(d));
+            lower_[d] = min;
+            extent[d] = max - min;
+        }
+        cell_size_ = cell_size;
+        std::size_t n_cells;
+        while (true)
+        {
+            n_cells = 1;
+            for (std::size_t d = 0; d < dim; d++)
+            {
+                n_cells_[d] = static_cast<std::size_t>(extent[d] / cell_size_) + 1;
+                n_cells *= n_cells_[d];
+            }
+            if (n_cells <= 2 * n + 1)
+            {
+                break;
+            }
+            cell_size_ *= 2;
+        }
+
+        // Count the particles of each cell
+        cell_of_.resize(n);
+        cell_start_.assign(n_cells + 1, 0);
+        parallel_for(n, 1, [&](std::size_t first, std::size_t last)
+                     {
+                         for (std::size_t i = first; i < last; i++)
+                         {
+                             std::array<float_t, dim> x;
+                             for (std::size_t d = 0; d < dim; d++)
+                             {
+                                 x[d] = particles.x(d)[i];
+                             }
+                             cell_of_[i] = static_cast<std::uint32_t>(cell_index(cell_coords(x)));
+                             std::atomic_ref<std::uint32_t>(cell_start_[cell_of_[i]]).fetch_add(1, std::memory_order_relaxed);
+                         } });
+
+        // Offsets of the cells (the last entry becomes the number of particles)
+        parallel_exclusive_scan(std::span(cell_start_));
+
+        // Store the particles at the offsets of their cells. The order of the
+        // particles of a cell depends on the order of the atomic increments,
+        // thus they are sorted, for reproducible results
+        std::vector<std::uint32_t> next(cell_start_.begin(), cell_start_.end() - 1);
+        particles_.resize(n);
+        parallel_for(n, 1, [&](std::size_t first, std::size_t last)
+                     {
+                         for (std::size_t i = first; i < last; i++)
+                         {
+                             const std::uint32_t pos = std::atomic_ref<std::uint32_t>(next[cell_of_[i]]).fetch_add(1, std::memory_order_relaxed);
+                             particles_[pos] = static_cast<std::uint32_t>(i);
+                         } });
+        parallel_for(n_cells, 1, [&](std::size_t first, std::size_t last)
+                     {
+                         for (std::size_t cell = first; cell < last; cell++)
+                         {
+                             std::sort(particles_.begin() + cell_start_[cell], particles_.begin() + cell_start_[cell + 1]);
+                         } });
+
+        // Copy the positions in the order of the cells, so that the positions
+        // of the particles of a row of cells are contiguous too
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            positions_[d].resize(n);
+        }
+        parallel_for(n, 1, [&](std::size_t first, std::size_t last)
+                     {
+                         for (std::size_t d = 0; d < dim; d++)
+                         {
+                             for (std::size_t k = first; k < last; k++)
+                             {
+                                 positions_[d][k] = particles.x(d)[particles_[k]];
+                             }
+                         } });
+    }
+
+    float_t cell_size() const
+    {
+        return cell_size_;
+    }
+
+    // Call f(j, r2) for each particle j within radius (not larger than the
+    // cell size) of position x, where r2 is its squared distance from x
+    template <typename F>
+    void for_each_within(const std::array<float_t, dim> &x, float_t radius, F f) const
+    {
+        const auto coords = cell_coords(x);
+        std::array<std::size_t, dim> lower;
+        std::array<std::size_t, dim> upper;
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            lower[d] = coords[d] > 0 ? coords[d] - 1 : 0;
+            upper[d] = std::min(coords[d] + 1, n_cells_[d] - 1);
+        }
+
+        // Visit the rows of cells along the first dimension, whose particles are
+        // contiguous, for each combination of the coordinates of the other dimensions
+        std::array<std::size_t, dim> row = lower;
+        while (true)
+        {
+            const std::size_t first_cell = cell_index(row);
+            const std::size_t last_cell = first_cell + upper[0] - lower[0];
+            // The distances are computed for blocks of up to 64 particles, and
+            // only then compared, into a mask of one bit per particle, so that
+            // the loop has no branches that depend on the positions
+            const std::size_t row_last = cell_start_[last_cell + 1];
+            for (std::size_t block = cell_start_[first_cell]; block < row_last; block += 64)
+            {
+                const std::size_t block_size = std::min<std::size_t>(64, row_last - block);
+                std::array<float_t, 64> r2{};
+                std::uint64_t mask = 0;
+                for (std::size_t k = 0; k < block_size; k++)
+                {
+                    for (std::size_t d = 0; d < dim; d++)
+                    {
+                        const float_t dx = positions_[d][block + k] - x[d];
+                        r2[k] += dx * dx;
+                    }
+                    mask |= std::uint64_t{r2[k] < radius * radius} << k;
+                }
+                for (; mask != 0; mask &= mask - 1)
+                {
+                    const std::size_t k = std::countr_zero(mask);
+                    f(particles_[block + k], r2[k]);
+                }
+            }
+
+            std::size_t d = 1;
+            for (; d < dim; d++)
+            {
+                if (row[d] < upper[d])
+                {
+                    row[d]++;
+                    break;
+                }
+                row[d] = lower[d];
+            }
+            if (d >= dim)
+            {
+                break;
+            }
+        }
+    }
+
+private:
+    std::array<std::size_t, dim> cell_coords(const std::array<float_t, dim> &x) const
+    {
+        std::array<std::size_t, dim> coords;
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            const float_t offset = std::max(float_t{0}, x[d] - lower_[d]);
+            coords[d] = std::min(static_cast<std::size_t>(offset / cell_size_), n_cells_[d] - 1);
+        }
+        return coords;
+    }
+
+    std::size_t cell_index(const std::array<std::size_t, dim> &coords) const
+    {
+        std::size_t idx = 0;
+        for (std::size_t d = dim; d-- > 0;)
+        {
+            idx = idx * n_cells_[d] + coords[d];
+        }
+        return idx;
+    }
+
+    std::array<float_t, dim> lower_{};
+    float_t cell_size_ = 1;
+    std::array<std::size_t, dim> n_cells_{};
+    std::vector<std::uint32_t> cell_start_;
+    std::vector<std::uint32_t> particles_;
+    std::vector<std::uint32_t> cell_of_;
+    std::array<AlignedVector<float_t>, dim> positions_;
+};
+
+// The VerletList class stores, for each particle, the particles within a
+// radius of cutoff + skin from it (in compressed sparse row format). As long
+// as no particle has moved by more than skin / 2 since the lists were built,
+// no pair of particles can have come within the cutoff of each other without
+// being in the lists, thus the lists are reused, and rebuilt (with a CellList)
+// only when a particle moves further. Kernels must still check the distance
+// of the pairs against the cutoff.
+template <float_type float_t, std::size_t dim>
+class VerletList
+{
+public:
+    VerletList(float_t cutoff, float_t skin)
+        : cutoff_(cutoff), skin_(skin)
+    {
+    }
+
+    // Rebuild the lists, if needed. Returns whether they were rebuilt
+    template <idx_type idx_t>
+    bool update(const ParticleSystem<idx_t, float_t, dim> &particles)
+    {
+        if (!needs_rebuild(particles))
+        {
+            return false;
+        }
+        build(particles);
+        return true;
+    }
+
+    std::span<const std::uint32_t> neighbors(std::size_t i) const
+    {
+        return std::span(neighbors_).subspan(start_[i], start_[i + 1] - start_[i]);
+    }
+
+    std::size_t n_neighbors() const
+    {
+        return neighbors_.size();
+    }
+
+    float_t cutoff() const
+    {
+        return cutoff_;
+    }
+
+private:
+    template <idx_type idx_t>
+    bool needs_rebuild(const ParticleSystem<idx_t, float_t, dim> &particles) const
+    {
+        const std::size_t n = particles.size();
+        if (x0_[0].size() != n)
+        {
+            return true;
+        }
+
+        // Largest squared displacement, per chunk
+        std::vector<float_t> partial(n_hardware_threads(), 0);
+        const std::size_t n_chunks = parallel_for_chunks(n, 1, [&](std::size_t chunk, std::size_t first, std::size_t last)
+                                                         {
+                                                             float_t max_r2 = 0;
+                                                             for (std::size_t i = first; i < last; i++)
+                                                             {
+                                                                 float_t r2 = 0;
+                                                                 for (std::size_t d = 0; d < dim; d++)
+                                                                 {
+                                                                     const float_t dx = particles.x(d)[i] - x0_[d][i];
+                                                                     r2 += dx * dx;
+                                                                 }
+                                                                 max_r2 = std::max(max_r2, r2);
+                                                             }
+                                                             partial[chunk] = max_r2; });
+        const float_t max_r2 = *std::max_element(partial.begin(), partial.begin() + n_chunks);
+        return 4 * max_r2 > skin_ * skin_;
+    }
+
+    template <idx_type idx_t>
+    void build(const ParticleSystem<idx_t, float_t, dim> &particles)
+    {
+        const std::size_t n = particles.size();
+        const float_t radius = cutoff_ + skin_;
+        cells_.build(particles, radius);
+
+        // Find the neighbors of the particles of each chunk, into a buffer per
+        // chunk, while counting them, turn the counts into offsets, and then copy
+        // each buffer to the offset of the first particle of its chunk
+        start_.assign(n + 1, 0);
+        std::vector<std::vector<std::uint32_t>> buffers(n_hardware_threads());
+        parallel_for_chunks(n, 1, [&](std::size_t chunk, std::size_t first, std::size_t last)
+                            {
+                                auto &buffer = buffers[chunk];
+                                for (std::size_t i = first; i < last; i++)
+                                {
+                                    std::array<float_t, dim> xi;
+                                    for (std::size_t d = 0; d < dim; d++)
+                                    {
+                                        xi[d] = particles.x(d)[i];
+                                    }
+                                    const std::size_t count = buffer.size();
+                                    cells_.for_each_within(xi, radius, [&](std::uint32_t j, float_t)
+                                                           {
+                                                               if (j != i)
+                                                               {
+                                                                   buffer.push_back(j);
+                                                               } });
+                                    start_[i] = static_cast<std::uint32_t>(buffer.size() - count);
+                                } });
+        neighbors_.resize(parallel_exclusive_scan(std::span(start_)));
+        parallel_for_chunks(n, 1, [&](std::size_t chunk, std::size_t first, std::size_t)
+                            { std::ranges::copy(buffers[chunk], neighbors_.begin() + start_[first]); });
+
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            x0_[d].assign(particles.x(d).begin(), particles.x(d).end());
+        }
+    }
+
+    float_t cutoff_;
+    float_t skin_;
+    CellList<float_t, dim> cells_;
+    std::vector<std::uint32_t> start_;
+    std::vector<std::uint32_t> neighbors_;
+    // Positions at the last build
+    std::array<AlignedVector<float_t>, dim> x0_;
+};
+
+// Sum of (cutoff^2 - r^2) over the pairs of particles within the cutoff, a
+// stand-in for the force loop of a short-range interaction
+template <idx_type idx_t, float_type float_t, std::size_t dim>
+double pair_sum(const ParticleSystem<idx_t, float_t, dim> &particles, const VerletList<float_t, dim> &list)
+{
+    const float_t cutoff2 = list.cutoff() * list.cutoff();
+    std::vector<double> partial(n_hardware_threads(), 0);
+    const std::size_t n_chunks = parallel_for_chunks(particles.size(), 1, [&](std::size_t chunk, std::size_t first, std::size_t last)
+                                                     {
+                                                         double sum = 0;
+                                                         for (std::size_t i = first; i < last; i++)
+                                                         {
+                                                             for (const std::uint32_t j : list.neighbors(i))
+                                                             {
+                                                                 float_t r2 = 0;
+                                                                 for (std::size_t d = 0; d < dim; d++)
+                                                                 {
+                                                                     const float_t dx = particles.x(d)[j] - particles.x(d)[i];
+                                                                     r2 += dx * dx;
+                                                                 }
+                                                                 sum += std::max(float_t{0}, cutoff2 - r2);
+                                                             }
+                                                         }
+                                                         partial[chunk] = sum; });
+    return std::accumulate(partial.begin(), partial.begin() + n_chunks, 0.0);
+}
+
+// Measure the neighbor search for n particles, placed at random in a cube
+// with (on average) density particles per unit volume, with a cutoff of 1:
+// the time per particle to build the lists, of the pair loop over them, and
+// of the O(N^2) pair loop (for small n only), and the number of rebuilds
+// over steps in which the particles drift at random velocities
+template <idx_type idx_t, float_type float_t, std::size_t dim>
+void benchmark_neighbor_search(std::size_t n)
+{
+    constexpr float_t cutoff = 1;
+    constexpr float_t skin = 0.3;
+    constexpr float_t density = 5;
+    constexpr std::size_t n_steps = 20;
+    constexpr float_t dt = 0.01;
+    const float_t side = std::pow(n / density, float_t{1} / dim);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float_t> position(0, side);
+    std::uniform_real_distribution<float_t> velocity(-1, 1);
+    ParticleSystem<idx_t, float_t, dim> particles;
+    particles.reserve(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        Particle<idx_t, float_t, dim> particle{.id_ = static_cast<idx_t>(i), .mass_ = 1, .x_ = {}, .u_ = {}};
+        std::ranges::generate(particle.x_, [&]
+                              { return position(gen); });
+        std::ranges::generate(particle.u_, [&]
+                              { return velocity(gen); });
+        particles.push_back(particle);
+    }
+
+    auto time_per_particle = [n](std::size_t n_repeats, auto f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < n_repeats; r++)
+        {
+            f();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count() / (n * n_repeats);
+    };
+    const std::size_t n_repeats = std::max<std::size_t>(3, 1e6 / n);
+
+    VerletList<float_t, dim> list(cutoff, skin);
+    const double build_ns = time_per_particle(n_repeats, [&]
+                                              {
+                                                  list = VerletList<float_t, dim>(cutoff, skin);
+                                                  list.update(particles); });
+    double sum = 0;
+    const double pairs_ns = time_per_particle(n_repeats, [&]
+                                              { sum = pair_sum(particles, list); });
+
+    // The O(N^2) loop, over all pairs
+    constexpr std::size_t max_direct = 20'000;
+    std::string direct = "-";
+    bool match = true;
+    if (n <= max_direct)
+    {
+        double direct_sum = 0;
+        const double direct_ns = time_per_particle(1, [&]
+                                                   {
+                                          for (std::size_t i = 0; i < n; i++)
+                                          {
+                                              for (std::size_t j = 0; j < n; j++)
+                                              {
+                                                  float_t r2 = 0;
+                                                  for (std::size_t d = 0; d < dim; d++)
+                                                  {
+                                                      const float_t dx = particles.x(d)[j] - particles.x(d)[i];
+                                                      r2 += dx * dx;
+                                                  }
+                                                  direct_sum += j != i ? std::max(float_t{0}, cutoff * cutoff - r2) : 0;
+                                              }
+                                          } });
+        direct = std::format("{:.1f} ns", direct_ns);
+        match = std::abs(direct_sum - sum) <= 1e-6 * std::abs(direct_sum);
+    }
+
+    // Drift, and update the lists, which are rebuilt only now and then
+    std::size_t n_rebuilds = 0;
+    const double update_ns = time_per_particle(1, [&]
+                                               {
+                                                   for (std::size_t s = 0; s < n_steps; s++)
+                                                   {
+                                                       for (std::size_t d = 0; d < dim; d++)
+                                                       {
+                                                           drift(n, dt, particles.u(d).data(), particles.x(d).data());
+                                                       }
+                                                       n_rebuilds += list.update(particles);
+                                                   } }) /
+                             n_steps;
+
+    std::cout << std::format("n: {:>8}, neighbors: {:>5.1f}, build: {:>7.1f} ns, pair loop: {:>6.1f} ns, O(N^2) loop: {:>10}, "
+                             "update: {:>6.1f} ns/step ({} rebuilds in {} steps){}\n",
+                             n, static_cast<double>(list.n_neighbors()) / n, build_ns, pairs_ns, direct,
+                             update_ns, n_rebuilds, n_steps, match ? "" : " (mismatch)");
+}
+
+// Space-filling curves, which visit the cells of a grid of 2^bits cells per
+// dimension one by one, and whose index along the curve (the key of a cell)
+// is such that cells with close keys are mostly close in space. Sorting the
+// particles by the keys of their cells places spatial neighbors close in
+// memory. The Z-order (Morton) curve interleaves the bits of the coordinates,
+// and jumps now and then across the grid. The Hilbert curve only moves
+// between adjacent cells, at the cost of some more work per key.
+enum class SpaceFillingCurve
+{
+    morton,
+    hilbert
+};
+
+constexpr std::string_view curve_name(SpaceFillingCurve curve)
+{
+    return curve == SpaceFillingCurve::morton ? "Morton" : "Hilbert";
+}
+
+// Spread the bits of a coordinate, so that there are dim - 1 zero bits between
+// each pair of consecutive bits
+template <std::size_t dim>
+std::uint64_t spread_bits(std::uint64_t c)
+{
+    if constexpr (dim == 1)
+    {
+        return c;
+    }
+    else if constexpr (dim == 2)
+    {
+        c &= 0x00000000ffffffff;
+        c = (c | c << 16) & 0x0000ffff0000ffff;
+        c = (c | c << 8) & 0x00ff00ff00ff00ff;
+        c = (c | c << 4) & 0x0f0f0f0f0f0f0f0f;
+        c = (c | c << 2) & 0x3333333333333333;
+        c = (c | c << 1) & 0x5555555555555555;
+        return c;
+    }
+    else if constexpr (dim == 3)
+    {
+        c &= 0x00000000001fffff;
+        c = (c | c << 32) & 0x001f00000000ffff;
+        c = (c | c << 16) & 0x001f0000ff0000ff;
+        c = (c | c << 8) & 0x100f00f00f00f00f;
+        c = (c | c << 4) & 0x10c30c30c30c30c3;
+        c = (c | c << 2) & 0x1249249249249249;
+        return c;
+    }
+    else
+    {
+        std::uint64_t spread = 0;
+        for (std::size_t b = 0; b < 64 / dim; b++)
+        {
+            spread |= ((c >> b) & 1) << (b * dim);
+        }
+        return spread;
+    }
+}
+
+// Key of a cell along a curve, from its coordinates, of bits bits each (at
+// most 64 / dim). Within each group of dim bits of the key, the bit of the
+// first coordinate is the most significant one
+template <SpaceFillingCurve curve, std::size_t dim>
+std::uint64_t curve_key(std::array<std::uint32_t, dim> coords, std::size_t bits)
+{
+    if constexpr (curve == SpaceFillingCurve::hilbert)
+    {
+        // Transform the coordinates in place, so that interleaving their bits
+        // gives the Hilbert index (J. Skilling, "Programming the Hilbert
+        // curve", AIP Conference Proceedings 707, 2004)
+        const std::uint32_t m = std::uint32_t{1} << (bits - 1);
+        for (std::uint32_t q = m; q > 1; q >>= 1)
+        {
+            const std::uint32_t p = q - 1;
+            for (std::size_t d = 0; d < dim; d++)
+            {
+                if (coords[d] & q)
+                {
+                    coords[0] ^= p;
+                }
+                else
+                {
+                    const std::uint32_t t = (coords[0] ^ coords[d]) & p;
+                    coords[0] ^= t;
+                    coords[d] ^= t;
+                }
+            }
+        }
+        for (std::size_t d = 1; d < dim; d++)
+        {
+            coords[d] ^= coords[d - 1];
+        }
+        std::uint32_t t = 0;
+        for (std::uint32_t q = m; q > 1; q >>= 1)
+        {
+            if (coords[dim - 1] & q)
+            {
+                t ^= q - 1;
+            }
+        }
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            coords[d] ^= t;
+        }
+    }
+
+    std::uint64_t key = 0;
+    for (std::size_t d = 0; d < dim; d++)
+    {
+        key |= spread_bits<dim>(coords[d]) << (dim - 1 - d);
+    }
+    return key;
+}
+
+// Number of bits per coordinate of the keys of cells in dim dimensions
+template <std::size_t dim>
+constexpr std::size_t curve_bits = std::min<std::size_t>(64 / dim, 32);
+
+// Smallest cube that contains the particles, as its lower corner and side
+template <idx_type idx_t, float_type float_t, std::size_t dim>
+std::pair<std::array<float_t, dim>, float_t> bounding_cube(const ParticleSystem<idx_t, float_t, dim> &particles)
+{
+    std::array<float_t, dim> lower{};
+    float_t side = 0;
+    for (std::size_t d = 0; d < dim && particles.size() > 0; d++)
+    {
+        const auto [min, max] = std::ranges::minmax(particles.x(d));
+        lower[d] = min;
+        side = std::max(side, max - min);
+    }
+    return {lower, side};
+}
+
+// Keys along a curve of the cells of the particles, over a grid of
+// 2^curve_bits cells per dimension that covers a cube
+template <SpaceFillingCurve curve, idx_type idx_t, float_type float_t, std::size_t dim>
+std::vector<std::uint64_t> curve_keys(const ParticleSystem<idx_t, float_t, dim> &particles,
+                                      const std::array<float_t, dim> &lower, float_t side)
+{
+    constexpr std::size_t bits = curve_bits<dim>;
+    // Slightly less than cells per unit length, so that the particles on the
+    // upper faces of the cube are in the last cells
+    const double scale = side > 0 ? std::ldexp(1.0, bits) / side * (1 - 1e-9) : 0;
+    std::vector<std::uint64_t> keys(particles.size());
+    parallel_for(particles.size(), 1, [&](std::size_t first, std::size_t last)
+                 {
+                     for (std::size_t i = first; i < last; i++)
+                     {
+                         std::array<std::uint32_t, dim> coords;
+                         for (std::size_t d = 0; d < dim; d++)
+                         {
+                             coords[d] = static_cast<std::uint32_t>((particles.x(d)[i] - lower[d]) * scale);
+                         }
+                         keys[i] = curve_key<curve, dim>(coords, bits);
+                     } });
+    return keys;
+}
+
+// Index of each particle by id, e.g. after the particles are reordered.
+// The ids may be in any order, and need not start at 0 or be contiguous.
+// If they are contiguous, the index of an id is read directly, and
+// otherwise it is found by a binary search over the sorted ids.
+template <idx_type idx_t>
+class IdIndex
+{
+public:
+    IdIndex() = default;
+
+    // Throws std::invalid_argument on duplicate ids
+    explicit IdIndex(std::span<const idx_t> ids)
+        : ids_(ids.size()), indices_(ids.size())
+    {
+        const std::size_t n = ids.size();
+        std::vector<std::uint64_t> keys(n);
+        std::ranges::transform(ids, keys.begin(), key);
+        std::iota(indices_.begin(), indices_.end(), 0);
+        parallel_radix_sort(std::span(keys), std::span(indices_));
+        if (std::ranges::adjacent_find(keys) != keys.end())
+        {
+            throw std::invalid_argument("Particle ids must be unique.\n");
+        }
+        std::ranges::transform(indices_, ids_.begin(), [ids](std::uint32_t idx)
+                               { return ids[idx]; });
+        is_contiguous_ = n == 0 || keys.back() - keys.front() == n - 1;
+    }
+
+    std::size_t size() const
+    {
+        return ids_.size();
+    }
+
+    // Update the indices, after the particle at index order[i] moved to index i
+    void reorder(std::span<const std::uint32_t> order)
+    {
+        std::vector<std::uint32_t> new_index(order.size());
+        for (std::size_t i = 0; i < order.size(); i++)
+        {
+            new_index[order[i]] = static_cast<std::uint32_t>(i);
+        }
+        for (std::uint32_t &idx : indices_)
+        {
+            idx = new_index[idx];
+        }
+    }
+
+    // Index of the particle with the given id, or size() if there is none
+    std::size_t find(idx_t id) const
+    {
+        const std::size_t n = size();
+        if (is_contiguous_)
+        {
+            const std::uint64_t offset = key(id) - key(ids_.empty() ? id : ids_.front());
+            return offset < n ? indices_[offset] : n;
+        }
+        const auto it = std::ranges::lower_bound(ids_, id);
+        return it != ids_.end() && *it == id ? indices_[it - ids_.begin()] : n;
+    }
+
+private:
+    // The id as an unsigned integer, in the same order (i.e. with the sign
+    // bit flipped), as a key of the radix sort
+    static std::uint64_t key(idx_t id)
+    {
+        if constexpr (std::is_signed_v<idx_t>)
+        {
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(id)) ^ (std::uint64_t{1} << 63);
+        }
+        else
+        {
+            return static_cast<std::uint64_t>(id);
+        }
+    }
+
+    // The sorted ids, and the index of the particle of each
+    std::vector<idx_t> ids_;
+    std::vector<std::uint32_t> indices_;
+    bool is_contiguous_ = true;
+};
+
+// Sort the particles along a space-filling curve, over a grid that covers
+// their bounding box (with cubic cells), in parallel. Returns the index of
+// each particle by id, since sorting changes the indices of the particles.
+// Throws std::invalid_argument on duplicate ids, before sorting.
+template <SpaceFillingCurve curve, idx_type idx_t, float_type float_t, std::size_t dim>
+IdIndex<idx_t> sort_spatially(ParticleSystem<idx_t, float_t, dim> &particles)
+{
+    const std::size_t n = particles.size();
+    IdIndex<idx_t> index_of_id(particles.ids());
+
+    // Key and original index of each particle
+    const auto [lower, side] = bounding_cube(particles);
+    std::vector<std::uint64_t> keys = curve_keys<curve>(particles, lower, side);
+    std::vector<std::uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    parallel_radix_sort(std::span(keys), std::span(order));
+
+    // Move each field to its sorted order, through a buffer
+    auto permute = [&]<typename T>(std::span<T> field)
+    {
+        std::vector<T> buffer(n);
+        parallel_for(n, 1, [&](std::size_t first, std::size_t last)
+                     {
+                         for (std::size_t i = first; i < last; i++)
+                         {
+                             buffer[i] = field[order[i]];
+                         } });
+        parallel_for(n, 1, [&](std::size_t first, std::size_t last)
+                     { std::copy(buffer.begin() + first, buffer.begin() + last, field.begin() + first); });
+    };
+    permute(particles.ids());
+    permute(particles.masses());
+    for (std::size_t d = 0; d < dim; d++)
+    {
+        permute(particles.x(d));
+        permute(particles.u(d));
+    }
+
+    index_of_id.reorder(order);
+    return index_of_id;
+}
+
+// Measure the neighbor search and the pair loop over the Verlet lists of n
+// random particles, before and after sorting the particles along a curve
+template <SpaceFillingCurve curve, idx_type idx_t, float_type float_t, std::size_t dim>
+void benchmark_spatial_sort(std::size_t n)
+{
+    constexpr float_t cutoff = 1;
+    constexpr float_t skin = 0.3;
+    constexpr float_t density = 5;
+    const float_t side = std::pow(n / density, float_t{1} / dim);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float_t> position(0, side);
+    ParticleSystem<idx_t, float_t, dim> particles;
+    particles.reserve(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        // Odd ids, so that they are found by a binary search
+        Particle<idx_t, float_t, dim> particle{.id_ = static_cast<idx_t>(2 * i + 1), .mass_ = 1, .x_ = {}, .u_ = {}};
+        std::ranges::generate(particle.x_, [&]
+                              { return position(gen); });
+        particles.push_back(particle);
+    }
+
+    auto time_per_particle = [n](std::size_t n_repeats, auto f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < n_repeats; r++)
+        {
+            f();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count() / (n * n_repeats);
+    };
+    const std::size_t n_repeats = std::max<std::size_t>(3, 1e6 / n);
+
+    // Time to build the lists, and of the pair loop, with the current order
+    auto time_neighbor_search = [&](double &sum)
+    {
+        VerletList<float_t, dim> list(cutoff, skin);
+        const double build_ns = time_per_particle(n_repeats, [&]
+                                                  {
+                                                      list = VerletList<float_t, dim>(cutoff, skin);
+                                                      list.update(particles); });
+        const double pairs_ns = time_per_particle(n_repeats, [&]
+                                                  { sum = pair_sum(particles, list); });
+        return std::pair{build_ns, pairs_ns};
+    };
+
+    double unsorted_sum;
+    const auto [unsorted_build_ns, unsorted_pairs_ns] = time_neighbor_search(unsorted_sum);
+
+    // Sort copies of the particles, since sorting sorted particles is faster
+    std::vector<ParticleSystem<idx_t, float_t, dim>> copies(n_repeats, particles);
+    std::size_t copy = 0;
+    IdIndex<idx_t> index_of_id;
+    const double sort_ns = time_per_particle(n_repeats, [&]
+                                             { index_of_id = sort_spatially<curve>(copies[copy++]); });
+    particles = std::move(copies.back());
+    copies.clear();
+
+    // The particles are found by id after sorting
+    bool found = true;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const auto id = static_cast<idx_t>(2 * i + 1);
+        const std::size_t idx = index_of_id.find(id);
+        found &= idx != n && particles.ids()[idx] == id && index_of_id.find(id - 1) == n;
+    }
+
+    double sorted_sum;
+    const auto [sorted_build_ns, sorted_pairs_ns] = time_neighbor_search(sorted_sum);
+    const bool match = found && std::abs(sorted_sum - unsorted_sum) <= 1e-6 * std::abs(unsorted_sum);
+
+    std::cout << std::format("n: {:>8}, {:<7} sort: {:>6.1f} ns, build: {:>7.1f} -> {:>7.1f} ns ({:.1f}x), pair loop: {:>6.1f} -> {:>6.1f} ns ({:.1f}x){}\n",
+                             n, curve_name(curve), sort_ns, unsorted_build_ns, sorted_build_ns, unsorted_build_ns / sorted_build_ns,
+                             unsorted_pairs_ns, sorted_pairs_ns, unsorted_pairs_ns / sorted_pairs_ns, match ? "" : " (mismatch)");
+}
+
+// The BarnesHutTree class approximates the gravitational accelerations of N
+// bodies (the particles, with G = 1) in O(N log N) time, rather than O(N^2).
+// The bodies are grouped into a tree of cubic cells, a quadtree in 2D and an
+// octree in 3D, in which each cell is split into the (up to 2^dim, non-empty)
+// cells of half its side, down to cells of at most leaf_size bodies. A cell
+// that is far enough from a body, as seen under an angle smaller than the
+// opening angle theta, acts on it as a single body at its center of mass;
+// otherwise it is opened, and its children act on the body instead.
+// The tree is built from the bodies sorted by their Morton keys, since the
+// bodies of each cell are then contiguous, and the children of a cell split
+// its bodies by the next dim bits of their keys. The top cells are split by
+// the calling thread, and the subtrees below them in parallel.
+template <float_type float_t, std::size_t dim>
+class BarnesHutTree
+{
+public:
+    static constexpr std::size_t leaf_size = 8;
+
+    template <idx_type idx_t>
+    void build(const ParticleSystem<idx_t, float_t, dim> &particles)
+    {
+        const std::size_t n = particles.size();
+        nodes_.clear();
+        if (n == 0)
+        {
+            return;
+        }
+
+        // Sort the bodies, by their keys over the bounding cube
+        auto [lower, side] = bounding_cube(particles);
+        side = side > 0 ? side : 1;
+        keys_ = curve_keys<SpaceFillingCurve::morton>(particles, lower, side);
+        order_.resize(n);
+        std::iota(order_.begin(), order_.end(), 0);
+        parallel_radix_sort(std::span(keys_), std::span(order_));
+        m_.resize(n);
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            x_[d].resize(n);
+        }
+        parallel_for(n, 1, [&](std::size_t first, std::size_t last)
+                     {
+                         for (std::size_t k = first; k < last; k++)
+                         {
+                             m_[k] = particles.masses()[order_[k]];
+                             for (std::size_t d = 0; d < dim; d++)
+                             {
+                                 x_[d][k] = particles.x(d)[order_[k]];
+                             }
+                         } });
+
+        // Split the top cells, down to about 4 cells per thread, leaving the
+        // cells at that level to be split in parallel
+        Node root{.side = side, .first = 0, .last = static_cast<std::uint32_t>(n)};
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            root.center[d] = lower[d] + side / 2;
+        }
+        nodes_.push_back(root);
+        const std::size_t task_level = (std::bit_width(4 * n_hardware_threads() - 1) + dim - 1) / dim;
+        std::vector<std::uint32_t> tasks;
+        split(nodes_, 0, 0, task_level, tasks);
+        const std::size_t n_top = nodes_.size();
+
+        // Split each task into its own nodes, the root first. The tasks are
+        // assigned to threads by their first body, to balance the bodies
+        std::vector<std::vector<Node>> subtrees(tasks.size());
+        std::vector<std::uint32_t> task_first(tasks.size());
+        for (std::size_t t = 0; t < tasks.size(); t++)
+        {
+            task_first[t] = nodes_[tasks[t]].first;
+        }
+        auto for_each_task = [&](auto f)
+        {
+            parallel_for(n, 1, [&](std::size_t first, std::size_t last)
+                         {
+                             for (std::size_t t = 0; t < tasks.size(); t++)
+                             {
+                                 if (task_first[t] >= first && task_first[t] < last)
+                                 {
+                                     f(t);
+                                 }
+                             } });
+        };
+        for_each_task([&](std::size_t t)
+                      {
+                          subtrees[t].push_back(nodes_[tasks[t]]);
+                          std::vector<std::uint32_t> no_tasks;
+                          split(subtrees[t], 0, task_level, curve_bits<dim> + 1, no_tasks); });
+
+        // Append the nodes of the subtrees, but their roots, which replace the
+        // nodes of their tasks
+        std::vector<std::size_t> offsets(tasks.size() + 1, n_top);
+        for (std::size_t t = 0; t < tasks.size(); t++)
+        {
+            offsets[t + 1] = offsets[t] + subtrees[t].size() - 1;
+        }
+        nodes_.resize(offsets.back());
+        for_each_task([&](std::size_t t)
+                      {
+                          // Local index k (but 0) is at offsets[t] + k - 1
+                          const std::size_t shift = offsets[t] - 1;
+                          for (std::size_t k = 0; k < subtrees[t].size(); k++)
+                          {
+                              Node node = subtrees[t][k];
+                              node.first_child += node.n_children > 0 ? shift : 0;
+                              nodes_[k == 0 ? tasks[t] : shift + k] = node;
+                          } });
+
+        // The moments of the top cells above the tasks, whose children come
+        // after them
+        for (std::size_t idx = n_top; idx-- > 0;)
+        {
+            if (nodes_[idx].n_children > 0 && std::ranges::find(tasks, idx) == tasks.end())
+            {
+                compute_moments(nodes_, idx);
+            }
+        }
+    }
+
+    // Accelerations of the particles the tree was built from (in their order),
+    // with a Plummer softening length, i.e. from a body at distance r, of mass
+    // m, m r / (r^2 + softening^2)^(3/2)
+    std::array<AlignedVector<float_t>, dim> accelerations(float_t theta, float_t softening) const
+    {
+        const std::size_t n = order_.size();
+        std::array<AlignedVector<float_t>, dim> acc;
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            acc[d].assign(nodes_.empty() ? 0 : n, 0);
+        }
+        if (nodes_.empty())
+        {
+            return acc;
+        }
+
+        const float_t inv_theta = 1 / theta;
+        const float_t softening2 = softening * softening;
+        // Each level pushes at most 2^dim children
+        constexpr std::size_t max_stack = (curve_bits<dim> + 1) * (std::size_t{1} << dim);
+
+        // The bodies are visited in Morton order, so that consecutive bodies
+        // traverse about the same cells
+        parallel_for(n, 1, [&](std::size_t first, std::size_t last)
+                     {
+                         std::array<std::uint32_t, max_stack> stack;
+                         for (std::size_t k = first; k < last; k++)
+                         {
+                             std::array<float_t, dim> xk;
+                             for (std::size_t d = 0; d < dim; d++)
+                             {
+                                 xk[d] = x_[d][k];
+                             }
+                             std::array<float_t, dim> ak{};
+                             auto add = [&](const std::array<float_t, dim> &dx, float_t r2, float_t m)
+                             {
+                                 r2 += softening2;
+                                 const float_t c = r2 > 0 ? m / (r2 * std::sqrt(r2)) : 0;
+                                 for (std::size_t d = 0; d < dim; d++)
+                                 {
+                                     ak[d] += c * dx[d];
+                                 }
+                             };
+
+                             std::size_t top = 0;
+                             stack[top++] = 0;
+                             while (top > 0)
+                             {
+                                 const Node &node = nodes_[stack[--top]];
+                                 std::array<float_t, dim> dx;
+                                 float_t r2 = 0;
+                                 for (std::size_t d = 0; d < dim; d++)
+                                 {
+                                     dx[d] = node.center_of_mass[d] - xk[d];
+                                     r2 += dx[d] * dx[d];
+                                 }
+
+                                 // The offset of the center of mass from the center
+                                 // of the cell accounts for bodies closer than it
+                                 const float_t open_radius = node.side * inv_theta + node.offset;
+                                 if (r2 > open_radius * open_radius)
+                                 {
+                                     add(dx, r2, node.mass);
+                                 }
+                                 else if (node.n_children == 0)
+                                 {
+                                     for (std::size_t j = node.first; j < node.last; j++)
+                                     {
+                                         float_t rj2 = 0;
+                                         for (std::size_t d = 0; d < dim; d++)
+                                         {
+                                             dx[d] = x_[d][j] - xk[d];
+                                             rj2 += dx[d] * dx[d];
+                                         }
+                                         // Not the body itself
+                                         add(dx, rj2, j != k ? m_[j] : 0);
+                                     }
+                                 }
+                                 else
+                                 {
+                                     for (std::uint32_t c = 0; c < node.n_children; c++)
+                                     {
+                                         stack[top++] = node.first_child + c;
+                                     }
+                                 }
+                             }
+
+                             for (std::size_t d = 0; d < dim; d++)
+                             {
+                                 acc[d][order_[k]] = ak[d];
+                             }
+                         } });
+        return acc;
+    }
+
+    std::size_t n_nodes() const
+    {
+        return nodes_.size();
+    }
+
+private:
+    struct Node
+    {
+        std::array<float_t, dim> center{};
+        std::array<float_t, dim> center_of_mass{};
+        float_t mass = 0;
+        float_t side = 0;
+        // Distance between the center and the center of mass
+        float_t offset = 0;
+        // Bodies of the cell
+        std::uint32_t first = 0;
+        std::uint32_t last = 0;
+        // Children of the cell, which are consecutive
+        std::uint32_t first_child = 0;
+        std::uint32_t n_children = 0;
+    };
+
+    // Split the cell of node idx, at level, into its children, recursively, and
+    // compute its moments. The cells at task_level that are not leaves are
+    // not split, but added to tasks
+    void split(std::vector<Node> &nodes, std::size_t idx, std::size_t level, std::size_t task_level,
+               std::vector<std::uint32_t> &tasks) const
+    {
+        Node node = nodes[idx];
+        if (node.last - node.first <= leaf_size || level == curve_bits<dim>)
+        {
+            compute_moments(nodes, idx);
+            return;
+        }
+        if (level == task_level)
+        {
+            tasks.push_back(static_cast<std::uint32_t>(idx));
+            return;
+        }
+
+        // The children are added before being split, to be consecutive
+        const std::size_t shift = dim * (curve_bits<dim> - level - 1);
+        constexpr std::uint64_t n_digits = std::uint64_t{1} << dim;
+        node.first_child = static_cast<std::uint32_t>(nodes.size());
+        std::uint32_t first = node.first;
+        for (std::uint64_t digit = 0; digit < n_digits; digit++)
+        {
+            const auto last = static_cast<std::uint32_t>(
+                std::partition_point(keys_.begin() + first, keys_.begin() + node.last, [&](std::uint64_t key)
+                                     { return ((key >> shift) & (n_digits - 1)) <= digit; }) -
+                keys_.begin());
+            if (last > first)
+            {
+                Node child{.side = node.side / 2, .first = first, .last = last};
+                for (std::size_t d = 0; d < dim; d++)
+                {
+                    const bool upper = (digit >> (dim - 1 - d)) & 1;
+                    child.center[d] = node.center[d] + (upper ? node.side : -node.side) / 4;
+                }
+                nodes.push_back(child);
+                node.n_children++;
+            }
+            first = last;
+        }
+        nodes[idx] = node;
+
+        for (std::size_t c = 0; c < node.n_children; c++)
+        {
+            split(nodes, node.first_child + c, level + 1, task_level, tasks);
+        }
+        compute_moments(nodes, idx);
+    }
+
+    // Mass and center of mass of a cell, from its children, or its bodies
+    void compute_moments(std::vector<Node> &nodes, std::size_t idx) const
+    {
+        Node &node = nodes[idx];
+        double mass = 0;
+        std::array<double, dim> moment{};
+        if (node.n_children == 0)
+        {
+            for (std::size_t j = node.first; j < node.last; j++)
+            {
+                mass += m_[j];
+                for (std::size_t d = 0; d < dim; d++)
+                {
+                    moment[d] += static_cast<double>(m_[j]) * x_[d][j];
+                }
+            }
+        }
+        else
+        {
+            for (std::size_t c = node.first_child; c < node.first_child + node.n_children; c++)
+            {
+                mass += nodes[c].mass;
+                for (std::size_t d = 0; d < dim; d++)
+                {
+                    moment[d] += static_cast<double>(nodes[c].mass) * nodes[c].center_of_mass[d];
+                }
+            }
+        }
+
+        node.mass = static_cast<float_t>(mass);
+        double offset2 = 0;
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            node.center_of_mass[d] = mass > 0 ? static_cast<float_t>(moment[d] / mass) : node.center[d];
+            const double dx = node.center_of_mass[d] - node.center[d];
+            offset2 += dx * dx;
+        }
+        node.offset = static_cast<float_t>(std::sqrt(offset2));
+    }
+
+    std::vector<Node> nodes_;
+    // Keys, positions and masses of the bodies, in Morton order, and the index
+    // of the particle of each body
+    std::vector<std::uint64_t> keys_;
+    std::array<AlignedVector<float_t>, dim> x_;
+    AlignedVector<float_t> m_;
+    std::vector<std::uint32_t> order_;
+};
+
+// Acceleration of particle i from all other particles, by direct summation
+template <idx_type idx_t, float_type float_t, std::size_t dim>
+std::array<double, dim> direct_acceleration(const ParticleSystem<idx_t, float_t, dim> &particles, std::size_t i, float_t softening)
+{
+    std::array<double, dim> acc{};
+    for (std::size_t j = 0; j < particles.size(); j++)
+    {
+        std::array<double, dim> dx;
+        double r2 = static_cast<double>(softening) * softening;
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            dx[d] = static_cast<double>(particles.x(d)[j]) - particles.x(d)[i];
+            r2 += dx[d] * dx[d];
+        }
+        const double c = j != i && r2 > 0 ? particles.masses()[j] / (r2 * std::sqrt(r2)) : 0;
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            acc[d] += c * dx[d];
+        }
+    }
+    return acc;
+}
+
+// Measure the Barnes-Hut tree for n bodies of a Plummer sphere (with a dense
+// core and sparse halo): the time per particle to build the tree, and to
+// compute the accelerations, for several opening angles, against the time of
+// direct summation, and their relative error, over a sample of particles
+template <idx_type idx_t, float_type float_t, std::size_t dim>
+void benchmark_barnes_hut(std::size_t n)
+{
+    constexpr float_t softening = 1e-3;
+    constexpr std::size_t n_samples = 1000;
+
+    // Positions of a Plummer sphere (of unit scale radius), by inverting its
+    // cumulative mass profile, and cutting off the last 0.1% of its mass
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::normal_distribution<double> normal;
+    ParticleSystem<idx_t, float_t, dim> particles;
+    particles.reserve(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const double r = 1 / std::sqrt(std::pow(uniform(gen) * 0.999, -2.0 / 3) - 1);
+        std::array<double, dim> direction;
+        std::ranges::generate(direction, [&]
+                              { return normal(gen); });
+        const double norm = std::sqrt(std::inner_product(direction.begin(), direction.end(), direction.begin(), 0.0));
+        Particle<idx_t, float_t, dim> particle{.id_ = static_cast<idx_t>(i), .mass_ = float_t(1) / n, .x_ = {}, .u_ = {}};
+        for (std::size_t d = 0; d < dim; d++)
+        {
+            particle.x_[d] = static_cast<float_t>(r * direction[d] / norm);
+        }
+        particles.push_back(particle);
+    }
+
+    auto time_ns = [](auto f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count();
+    };
+
+    // Direct summation, over a sample of the particles
+    const std::size_t n_sampled = std::min(n, n_samples);
+    std::vector<std::array<double, dim>> exact(n_sampled);
+    const double direct_ns = time_ns([&]
+                                     {
+                                         for (std::size_t s = 0; s < n_sampled; s++)
+                                         {
+                                             exact[s] = direct_acceleration(particles, s * n / n_sampled, softening);
+                                         } }) /
+                             n_sampled;
+
+    BarnesHutTree<float_t, dim> tree;
+    const double build_ns = time_ns([&]
+                                    { tree.build(particles); }) /
+                            n;
+    std::cout << std::format("n: {:>8}, build: {:>6.1f} ns ({} nodes), direct summation: {:>10.1f} ns\n",
+                             n, build_ns, tree.n_nodes(), direct_ns);
+
+    for (const float_t theta : {0.3, 0.5, 0.7, 1.0})
+    {
+        std::array<AlignedVector<float_t>, dim> acc;
+        const double tree_ns = time_ns([&]
+                                       { acc = tree.accelerations(theta, softening); }) /
+                               n;
+
+        double sum_error2 = 0;
+        double max_error = 0;
+        for (std::size_t s = 0; s < n_sampled; s++)
+        {
+            double diff2 = 0;
+            double norm2 = 0;
+            for (std::size_t d = 0; d < dim; d++)
+            {
+                const double diff = acc[d][s * n / n_sampled] - exact[s][d];
+                diff2 += diff * diff;
+                norm2 += exact[s][d] * exact[s][d];
+            }
+            const double error = std::sqrt(diff2 / norm2);
+            sum_error2 += error * error;
+            max_error = std::max(max_error, error);
+        }
+        std::cout << std::format("  theta: {:.1f}, accelerations: {:>8.1f} ns ({:>6.1f}x), relative error: RMS {:.1e}, max {:.1e}\n",
+                                 theta, tree_ns, direct_ns / tree_ns, std::sqrt(sum_error2 / n_sampled), max_error);
+    }
+}
+
 int main()
 {
     std::cout << Particle<int, float, 2>{.id_ = 10, .mass_ = 5, .x_ = {3, 4}, .u_ = {1, 2}};
+
+    // The same particle, stored in a ParticleSystem and accessed through a proxy
+    ParticleSystem<int, float, 2> particles;
+    particles.push_back({.id_ = 10, .mass_ = 5, .x_ = {3, 4}, .u_ = {1, 2}});
+    particles[0].x_[0] += 1;
+    std::cout << Particle<int, float, 2>(particles[0]);
+
+    // Compare the array of structs (AoS) and the structure of arrays (SoA) layouts
+    std::size_t n = 1000;
+    for (int exp = 3; exp <= BENCHMARK_MAX_EXP; exp++, n *= 10)
+    {
+        benchmark_layouts<int, float, 3>(n);
+    }
+
+    // Compare the integrators, with a scalar loop over an array of structs
+    n = 1000;
+    for (int exp = 3; exp <= BENCHMARK_MAX_EXP; exp++, n *= 10)
+    {
+        std::cout << std::format("n: {}\n", n);
+        benchmark_integrator<Integrator::explicit_euler, int, float, 3>(n);
+        benchmark_integrator<Integrator::symplectic_euler, int, float, 3>(n);
+        benchmark_integrator<Integrator::velocity_verlet, int, float, 3>(n);
+        benchmark_integrator<Integrator::leapfrog, int, float, 3>(n);
+    }
+
+    // Neighbor search with cell lists and Verlet lists, which scales as O(N).
+    // The lists take some 200 bytes per particle, thus at most 10^6 particles
+    n = 1000;
+    for (int exp = 3; exp <= std::min(BENCHMARK_MAX_EXP, 6); exp++, n *= 10)
+    {
+        benchmark_neighbor_search<int, float, 3>(n);
+    }
+
+    // Neighbor search before and after sorting the particles along a curve
+    n = 1000;
+    for (int exp = 3; exp <= std::min(BENCHMARK_MAX_EXP, 6); exp++, n *= 10)
+    {
+        benchmark_spatial_sort<SpaceFillingCurve::morton, int, float, 3>(n);
+        benchmark_spatial_sort<SpaceFillingCurve::hilbert, int, float, 3>(n);
+    }
+
+    // Gravity with a Barnes-Hut tree, against direct summation. The smallest
+    // opening angle takes about a minute for 10^6 particles, thus at most 10^5
+    n = 1000;
+    for (int exp = 3; exp <= std::min(BENCHMARK_MAX_EXP, 5); exp++, n *= 10)
+    {
+        benchmark_barnes_hut<int, float, 3>(n);
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -1,57 +1,2454 @@
 #include <array>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <concepts>
+#include <span>
+#include <cstdint>
+#include <bit>
 #include <algorithm>
 #include <functional>
 #include <ranges>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <format>
 #include <iostream>
 #include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
-template <typename KeyType, typename ValueType, std::size_t Size>
+// Hash functions for the keys of Map
+// Strings are hashed with FNV-1a, integers and enumerations with the
+// finalizer of MurmurHash3 (fmix64). Both can be evaluated at compile time.
+constexpr std::uint64_t mix(std::uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+constexpr std::uint64_t hash_key(std::string_view key)
+{
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : key)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+template <typename T>
+    requires(std::is_integral_v<T> || std::is_enum_v<T>)
+constexpr std::uint64_t hash_key(T key)
+{
+    return mix(static_cast<std::uint64_t>(key));
+}
+
+// String key, whose hash is computed once, on construction, rather than by
+// every lookup. A key that is looked up in several maps, or several times,
+// is hashed only once, and a lookup by it compares its hash (fingerprint)
+// and length with those of the single candidate key, before its characters.
+class HashedKey
+{
+public:
+    constexpr explicit HashedKey(std::string_view str)
+        : str_(str), hash_(hash_key(str))
+    {
+    }
+
+    constexpr std::string_view str() const
+    {
+        return str_;
+    }
+
+    constexpr std::uint64_t hash() const
+    {
+        return hash_;
+    }
+
+    friend constexpr bool operator==(const HashedKey &lhs, std::string_view rhs)
+    {
+        return lhs.str_ == rhs;
+    }
+
+private:
+    std::string_view str_;
+    std::uint64_t hash_;
+};
+
+constexpr std::uint64_t hash_key(const HashedKey &key)
+{
+    return key.hash();
+}
+
+// String literal as a template argument
+template <std::size_t N>
+struct fixed_string
+{
+    constexpr fixed_string(const char (&str)[N])
+    {
+        std::copy_n(str, N, chars);
+    }
+
+    constexpr std::string_view view() const
+    {
+        return {chars, N - 1};
+    }
+
+    char chars[N];
+};
+
+// The hash of "green"_key is computed at compile time. The key refers to the
+// template argument, which is a static object, thus it never dangles.
+template <fixed_string Str>
+consteval HashedKey operator""_key()
+{
+    return HashedKey(Str.view());
+}
+
+// Perfect hashing (CHD: Compress, Hash and Displace)
+// A perfect hash function maps each of a fixed set of n keys to a distinct
+// slot in [0, n), so that a lookup needs a single probe (and key comparison).
+// The keys are first split into n buckets, based on their hash. Then, for
+// each bucket (largest first), a seed is searched for, which maps the keys of
+// the bucket to free slots. The seed holds a salt and a displacement: the
+// slot of a key is (mix(hash ^ salt) % n + displacement) % n. Thus, rather
+// than trying seeds at random, until all the keys of a bucket land on free
+// slots, the search moves the first key to each free slot in turn, and only
+// checks the slots of the others. A bucket with a single key, as are most of
+// those placed last, when few slots are free, takes the first free slot.
+
+// A seed holds a salt (high 8 bits) and a displacement (low 24 bits)
+constexpr std::uint32_t perfect_hash_seed(std::uint32_t salt, std::uint32_t displacement)
+{
+    return salt << 24 | displacement;
+}
+
+// Slot of a key before its displacement
+[[gnu::always_inline]] constexpr std::size_t perfect_hash_base(std::uint64_t hash, std::uint32_t salt, std::size_t n)
+{
+    return mix(hash ^ (salt * 0x9e3779b97f4a7c15ULL)) % n;
+}
+
+// Inlined, so that the modulo by the size of a Map is a multiplication
+[[gnu::always_inline]] constexpr std::size_t perfect_hash_slot(std::uint64_t hash, std::span<const std::uint32_t> seeds)
+{
+    const std::size_t n = seeds.size();
+    const std::uint32_t seed = seeds[hash % n];
+    const std::size_t slot = perfect_hash_base(hash, seed >> 24, n) + (seed & 0xFFFFFF);
+    // Half of the slots wrap around, so a branch would be mispredicted
+    return slot - n * static_cast<std::size_t>(slot >= n);
+}
+
+// Compute the seeds of the perfect hash function of the keys with the
+// given hashes, and the slot of each key (slots[i] for hashes[i])
+// Throws if two keys have the same hash (e.g. duplicate keys), in which
+// case no perfect hash function exists
+// Constant evaluation is charged for every call, thus the loops access
+// the spans and vectors through raw pointers, rather than operator[].
+constexpr void build_perfect_hash(std::span<const std::uint64_t> hashes,
+                                  std::span<std::uint32_t> seeds,
+                                  std::span<std::size_t> slots)
+{
+    const std::size_t n = hashes.size();
+    const std::uint64_t *hash = hashes.data();
+    std::size_t *slot_of = slots.data();
+
+    // Sort the hashes by bucket (counting sort)
+    std::vector<std::size_t> offsets_storage(n + 1);
+    std::size_t *offsets = offsets_storage.data();
+    for (std::size_t i = 0; i < n; i++)
+    {
+        offsets[hash[i] % n + 1]++;
+    }
+    std::size_t max_size = 0;
+    for (std::size_t b = 0; b < n; b++)
+    {
+        max_size = std::max(max_size, offsets[b + 1]);
+        offsets[b + 1] += offsets[b];
+    }
+    // Index in hashes of each sorted hash
+    std::vector<std::size_t> keys_storage(n);
+    std::vector<std::uint64_t> sorted_storage(n);
+    std::size_t *keys = keys_storage.data();
+    std::uint64_t *sorted = sorted_storage.data();
+    // The slots are not computed yet, so they hold the fill of each bucket
+    std::fill_n(slot_of, n, 0);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const std::size_t b = hash[i] % n;
+        const std::size_t k = offsets[b] + slot_of[b]++;
+        keys[k] = i;
+        sorted[k] = hash[i];
+    }
+
+    // Equal hashes fall in the same bucket, so they are found by comparing
+    // the hashes of each bucket, before the search tries all the seeds
+    for (std::size_t b = 0; b < n; b++)
+    {
+        for (std::size_t k = offsets[b]; k < offsets[b + 1]; k++)
+        {
+            for (std::size_t j = offsets[b]; j < k; j++)
+            {
+                if (sorted[j] == sorted[k])
+                {
+                    throw std::invalid_argument("Could not build perfect hash (duplicate keys)");
+                }
+            }
+        }
+    }
+
+    // Largest buckets first, while most slots are still free (counting sort)
+    std::vector<std::size_t> size_offsets(max_size + 2);
+    for (std::size_t b = 0; b < n; b++)
+    {
+        size_offsets[max_size - (offsets[b + 1] - offsets[b]) + 1]++;
+    }
+    for (std::size_t size = 0; size <= max_size; size++)
+    {
+        size_offsets[size + 1] += size_offsets[size];
+    }
+    std::vector<std::size_t> buckets_storage(n);
+    std::size_t *buckets = buckets_storage.data();
+    for (std::size_t b = 0; b < n; b++)
+    {
+        buckets[size_offsets[max_size - (offsets[b + 1] - offsets[b])]++] = b;
+    }
+
+    // The free slots, in any order, and the position of each slot among them
+    // A slot is taken by swapping it past the first n_free ones
+    std::vector<std::size_t> free_slots_storage(n);
+    std::vector<std::size_t> free_pos_storage(n);
+    std::size_t *free_slots = free_slots_storage.data();
+    std::size_t *free_pos = free_pos_storage.data();
+    for (std::size_t slot = 0; slot < n; slot++)
+    {
+        free_slots[slot] = slot;
+        free_pos[slot] = slot;
+    }
+    std::size_t n_free = n;
+
+    // For each salt, each free slot is tried for the first key of the bucket
+    constexpr std::uint32_t n_salts = 1u << 8;
+    const std::size_t n_displacements = std::min(n, std::size_t{1} << 24);
+    std::vector<std::size_t> bases_storage(max_size);
+    std::vector<std::size_t> candidates_storage(max_size);
+    std::size_t *bases = bases_storage.data();
+    std::size_t *candidates = candidates_storage.data();
+    std::fill(seeds.begin(), seeds.end(), 0);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const std::size_t b = buckets[i];
+        const std::size_t first = offsets[b];
+        const std::size_t size = offsets[b + 1] - first;
+        if (size == 0)
+        {
+            break; // All the remaining buckets are empty
+        }
+
+        bool placed = false;
+        for (std::uint32_t salt = 0; salt < n_salts && !placed; salt++)
+        {
+            for (std::size_t k = 0; k < size; k++)
+            {
+                bases[k] = perfect_hash_base(sorted[first + k], salt, n);
+            }
+            for (std::size_t f = 0; f < n_free && !placed; f++)
+            {
+                const std::size_t displacement = free_slots[f] >= bases[0] ? free_slots[f] - bases[0] : free_slots[f] + n - bases[0];
+                if (displacement >= n_displacements)
+                {
+                    continue;
+                }
+
+                // The slots of the other keys must be free, and distinct
+                candidates[0] = free_slots[f];
+                std::size_t k = 1;
+                for (; k < size; k++)
+                {
+                    const std::size_t slot = bases[k] + displacement;
+                    candidates[k] = slot < n ? slot : slot - n;
+                    if (free_pos[candidates[k]] >= n_free || std::find(candidates, candidates + k, candidates[k]) != candidates + k)
+                    {
+                        break;
+                    }
+                }
+                if (k < size)
+                {
+                    continue;
+                }
+
+                for (k = 0; k < size; k++)
+                {
+                    const std::size_t slot = candidates[k];
+                    const std::size_t last = free_slots[--n_free];
+                    free_slots[free_pos[slot]] = last;
+                    free_pos[last] = free_pos[slot];
+                    free_slots[n_free] = slot;
+                    free_pos[slot] = n_free;
+                    slot_of[keys[first + k]] = slot;
+                }
+                seeds[b] = perfect_hash_seed(salt, static_cast<std::uint32_t>(displacement));
+                placed = true;
+            }
+        }
+        if (!placed)
+        {
+            throw std::invalid_argument("Could not build perfect hash");
+        }
+    }
+}
+
+// Eytzinger layout
+// The sorted elements are stored in the order of a breadth-first traversal
+// of the (implicit) balanced binary search tree over them, i.e. the root
+// first, then its 2 children, then the 4 grandchildren etc. The children of
+// the element at 1-based position k are at positions 2k and 2k+1. Thus, a
+// binary search accesses the elements from the front of the array towards its
+// back, and the top levels of the tree, which every search visits, share a
+// few cache lines. Moreover, the 16 descendants of an element four levels down
+// are contiguous, so they can be prefetched while the search descends.
+
+// Position of the successor (in ascending order) of the element at 0-based
+// position pos, or n if it is the largest element
+constexpr std::size_t eytzinger_next(std::size_t pos, std::size_t n)
+{
+    std::size_t k = pos + 1;
+    if (2 * k + 1 <= n)
+    {
+        // Leftmost element of the right subtree
+        k = 2 * k + 1;
+        while (2 * k <= n)
+        {
+            k = 2 * k;
+        }
+    }
+    else
+    {
+        // Closest ancestor, of which the element is in the left subtree
+        k >>= std::countr_one(k) + 1;
+    }
+    return k == 0 ? n : k - 1;
+}
+
+// Compute the rank (in ascending order) of the element
+// to be stored at each position (ranks[pos])
+constexpr void build_eytzinger(std::span<std::size_t> ranks)
+{
+    const std::size_t n = ranks.size();
+    std::size_t pos = 0;
+    while (2 * pos + 1 < n)
+    {
+        pos = 2 * pos + 1; // Smallest element
+    }
+    for (std::size_t rank = 0; rank < n; rank++)
+    {
+        ranks[pos] = rank;
+        pos = eytzinger_next(pos, n);
+    }
+}
+
+// Position of the first element that is not less than key,
+// or elements.size() if there is no such element
+// The descent is branchless: the comparison selects the child
+template <typename T, typename Key, typename Proj = std::identity>
+constexpr std::size_t eytzinger_lower_bound(std::span<const T> elements, const Key &key, Proj proj = {})
+{
+    const std::size_t n = elements.size();
+    std::size_t k = 1;
+    while (k <= n)
+    {
+        if (!std::is_constant_evaluated() && 16 * k <= n)
+        {
+            __builtin_prefetch(&elements[16 * k - 1]);
+        }
+        k = 2 * k + static_cast<std::size_t>(std::invoke(proj, elements[k - 1]) < key);
+    }
+    // Undo the right turns after the last left turn, and the left turn itself
+    k >>= std::countr_one(k) + 1;
+    return k == 0 ? n : k - 1;
+}
+
+// SIMD key scan
+// The keys are compared with the searched key a whole vector at a time (16
+// bytes with SSE2, 32 with AVX2), which yields all bits set in the lanes that
+// are equal. This is turned into a bitmask (movemask) with one bit per key,
+// so that the index of the first equal key is given by the number of
+// trailing zeros.
+#if defined(__SSE2__)
+template <std::unsigned_integral T>
+__m128i sse_broadcast(T key)
+{
+    if constexpr (sizeof(T) == 1)
+    {
+        return _mm_set1_epi8(static_cast<char>(key));
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        return _mm_set1_epi16(static_cast<short>(key));
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        return _mm_set1_epi32(static_cast<int>(key));
+    }
+    else
+    {
+        return _mm_set1_epi64x(static_cast<long long>(key));
+    }
+}
+
+// One bit per key of the 16 bytes of keys, set if the key is equal to needle
+template <std::unsigned_integral T>
+unsigned sse_equal_mask(const T *keys, __m128i needle)
+{
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys));
+    if constexpr (sizeof(T) == 1)
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        // Narrow the 16-bit lanes to bytes, one byte per key
+        const __m128i equal = _mm_cmpeq_epi16(block, needle);
+        return _mm_movemask_epi8(_mm_packs_epi16(equal, _mm_setzero_si128()));
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, needle)));
+    }
+    else
+    {
+        // SSE2 has no 64-bit comparison: both 32-bit halves must be equal
+        const __m128i equal = _mm_cmpeq_epi32(block, needle);
+        const __m128i swapped = _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_movemask_pd(_mm_castsi128_pd(_mm_and_si128(equal, swapped)));
+    }
+}
+#endif
+
+#if defined(__AVX2__)
+template <std::unsigned_integral T>
+__m256i avx_broadcast(T key)
+{
+    if constexpr (sizeof(T) == 1)
+    {
+        return _mm256_set1_epi8(static_cast<char>(key));
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        return _mm256_set1_epi16(static_cast<short>(key));
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        return _mm256_set1_epi32(static_cast<int>(key));
+    }
+    else
+    {
+        return _mm256_set1_epi64x(static_cast<long long>(key));
+    }
+}
+
+// One bit per key of the 32 bytes of keys, set if the key is equal to needle
+template <std::unsigned_integral T>
+unsigned avx_equal_mask(const T *keys, __m256i needle)
+{
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys));
+    if constexpr (sizeof(T) == 1)
+    {
+        return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        // The narrowing works within each 128-bit half, so the bits of the keys
+        // of the upper half end up in bits 16-23 of the mask
+        const __m256i equal = _mm256_cmpeq_epi16(block, needle);
+        const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_packs_epi16(equal, _mm256_setzero_si256())));
+        return (mask & 0xFFu) | ((mask >> 8) & 0xFF00u);
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle)));
+    }
+    else
+    {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(block, needle)));
+    }
+}
+#endif
+
+// Index of the first of the n keys equal to key, or n if none is
+// The scan returns at the first vector with an equal key. The keys after
+// the last whole vector are compared by a last vector, which overlaps the
+// previous one, rather than one by one.
+template <std::unsigned_integral T>
+std::size_t simd_find_key(const T *keys, std::size_t n, T key)
+{
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    constexpr std::size_t avx_width = 32 / sizeof(T);
+    if (n >= avx_width)
+    {
+        const __m256i needle = avx_broadcast(key);
+        for (; i + avx_width <= n; i += avx_width)
+        {
+            if (const unsigned mask = avx_equal_mask(keys + i, needle); mask != 0)
+            {
+                return i + std::countr_zero(mask);
+            }
+        }
+        if (i < n)
+        {
+            const unsigned mask = avx_equal_mask(keys + n - avx_width, needle);
+            return mask != 0 ? n - avx_width + std::countr_zero(mask) : n;
+        }
+        return n;
+    }
+#endif
+#if defined(__SSE2__)
+    constexpr std::size_t sse_width = 16 / sizeof(T);
+    if (n >= sse_width)
+    {
+        const __m128i needle = sse_broadcast(key);
+        for (; i + sse_width <= n; i += sse_width)
+        {
+            if (const unsigned mask = sse_equal_mask(keys + i, needle); mask != 0)
+            {
+                return i + std::countr_zero(mask);
+            }
+        }
+        if (i < n)
+        {
+            const unsigned mask = sse_equal_mask(keys + n - sse_width, needle);
+            return mask != 0 ? n - sse_width + std::countr_zero(mask) : n;
+        }
+        return n;
+    }
+#endif
+    for (; i < n; i++)
+    {
+        if (keys[i] == key)
+        {
+            return i;
+        }
+    }
+    return n;
+}
+
+// Layouts of the pairs of a Map
+// PerfectHashLayout: pairs in the order of a perfect hash function of the keys
+// (one probe per lookup, any hashable keys).
+// EytzingerLayout: pairs sorted by key, in Eytzinger order (O(log n) probes per
+// lookup with predictable memory accesses, ordered keys, ordered queries).
+// SimdScanLayout: pairs in the given order, with the keys scanned with SIMD
+// instructions (integral or enum keys). The scan stops at the first vector
+// with the key, so it beats the perfect hash when the keys fit in a single
+// vector (e.g. 8 32-bit keys with AVX2, 4 with SSE2), or when most lookups
+// are of the first few keys, which are then given first. For lookups spread
+// evenly over more keys, the perfect hash is faster.
+struct PerfectHashLayout
+{
+};
+
+struct EytzingerLayout
+{
+};
+
+struct SimdScanLayout
+{
+};
+
+// The Map class is an immutable associative container, whose
+// keys are fixed on construction. The pairs are stored in the order
+// given by a perfect hash function of their keys, which the constructor
+// builds. Thus, a lookup computes the hash of the key, and compares the
+// key with the single pair that it may be equal to. If the Map is
+// constexpr, the perfect hash function is built at compile time, and
+// a lookup with a constant key can be evaluated at compile time as well.
+// This takes about 22M of the 33M operations that GCC allows by default
+// for 10000 keys (see large_map in main), beyond which the limit must be
+// raised with -fconstexpr-ops-limit.
+// With std::string_view keys (which refer to string literals) a static
+// constexpr Map is placed in read-only memory (.rodata) by the compiler,
+// so it costs nothing at startup, unlike a Map with std::string keys,
+// which must be constructed at runtime.
+// Alternatively, the pairs are sorted and stored in Eytzinger layout,
+// which also supports lower_bound and range queries.
+// The keys and the values are stored in separate arrays (structure of
+// arrays), so that probing touches only the densely packed keys, and a
+// value is read only on a hit. For keys that are not integers, the perfect
+// hash layout also stores a 32-bit fingerprint of the hash of each key,
+// which is compared first, so that a miss rarely reads (or compares) a key.
+template <typename KeyType, typename ValueType, std::size_t Size, typename Layout = PerfectHashLayout>
 class Map
 {
+    static_assert(Size > 0, "Map must have at least one key");
+
+    static constexpr bool is_perfect_hash = std::is_same_v<Layout, PerfectHashLayout>;
+    static constexpr bool is_eytzinger = std::is_same_v<Layout, EytzingerLayout>;
+    static constexpr bool is_simd_scan = std::is_same_v<Layout, SimdScanLayout>;
+    static_assert(is_perfect_hash || is_eytzinger || is_simd_scan, "Unknown Map layout");
+
+    static constexpr bool is_integer_key = std::is_integral_v<KeyType> || std::is_enum_v<KeyType>;
+    static_assert(!is_simd_scan || is_integer_key, "SimdScanLayout requires integral or enum keys");
+    static constexpr bool has_fingerprints = is_perfect_hash && !is_integer_key;
+    static constexpr bool is_string_key = std::is_convertible_v<const KeyType &, std::string_view>;
+
+    // Keys of the SIMD scan, as unsigned integers of the same size
+    using key_bits = std::conditional_t<sizeof(KeyType) == 1, std::uint8_t,
+                                        std::conditional_t<sizeof(KeyType) == 2, std::uint16_t,
+                                                           std::conditional_t<sizeof(KeyType) == 4, std::uint32_t, std::uint64_t>>>;
+    using stored_key = std::conditional_t<is_simd_scan, key_bits, KeyType>;
+    // The arrays are filled after they are default-initialized, if they can be
+    static constexpr bool is_default_initializable = std::default_initializable<KeyType> && std::default_initializable<ValueType>;
+
 public:
-    Map(const std::array<std::pair<KeyType, ValueType>, Size> &data)
-        : data_(data)
+    using value_type = std::pair<KeyType, ValueType>;
+    using const_reference = std::pair<const KeyType &, const ValueType &>;
+
+    constexpr Map(const std::array<value_type, Size> &data)
+        requires is_default_initializable
+        : Map(data, place(data))
+    {
+    }
+
+    // Otherwise, the keys and the values are constructed in place, which
+    // is slower to compile for large maps
+    constexpr Map(const std::array<value_type, Size> &data)
+        requires(!is_default_initializable)
+        : Map(data, place(data), std::make_index_sequence<Size>{})
+    {
+    }
+
+    constexpr ValueType at(const KeyType &key) const
+    {
+        const std::size_t idx = find_index(key);
+        if (idx == Size) [[unlikely]]
+        {
+            // Looking up a missing key at compile time is a compile error
+            throw(std::range_error("Key not found in map.\n"));
+        }
+
+        return values_[idx];
+    }
+
+    // Lookups that do not throw, for keys that are expected to be missing.
+    // Unwinding the exception of at() costs microseconds per miss.
+
+    // Value of the given key, or nullptr
+    constexpr const ValueType *find(const KeyType &key) const
+    {
+        const std::size_t idx = find_index(key);
+        return idx == Size ? nullptr : &values_[idx];
+    }
+
+    constexpr bool contains(const KeyType &key) const
+    {
+        return find_index(key) != Size;
+    }
+
+    // Value of the given key, or default_value
+    constexpr ValueType get_or(const KeyType &key, const ValueType &default_value) const
+    {
+        const std::size_t idx = find_index(key);
+        return idx == Size ? default_value : values_[idx];
+    }
+
+    // Value of the given key, or an empty optional
+    constexpr std::optional<ValueType> get(const KeyType &key) const
+    {
+        const std::size_t idx = find_index(key);
+        return idx == Size ? std::nullopt : std::optional<ValueType>(values_[idx]);
+    }
+
+    // Lookups by a string key, whose hash has already been computed
+    constexpr ValueType at(const HashedKey &key) const
+        requires is_string_key
+    {
+        const std::size_t idx = find_index(key);
+        if (idx == Size) [[unlikely]]
+        {
+            throw(std::range_error("Key not found in map.\n"));
+        }
+        return values_[idx];
+    }
+
+    constexpr const ValueType *find(const HashedKey &key) const
+        requires is_string_key
+    {
+        const std::size_t idx = find_index(key);
+        return idx == Size ? nullptr : &values_[idx];
+    }
+
+    constexpr bool contains(const HashedKey &key) const
+        requires is_string_key
+    {
+        return find_index(key) != Size;
+    }
+
+    constexpr ValueType get_or(const HashedKey &key, const ValueType &default_value) const
+        requires is_string_key
+    {
+        const std::size_t idx = find_index(key);
+        return idx == Size ? default_value : values_[idx];
+    }
+
+    constexpr std::optional<ValueType> get(const HashedKey &key) const
+        requires is_string_key
+    {
+        const std::size_t idx = find_index(key);
+        return idx == Size ? std::nullopt : std::optional<ValueType>(values_[idx]);
+    }
+
+    // Look up each of the keys, and store its value at the same index of values
+    // (the values of missing keys are left unchanged). Returns the number of
+    // keys found. With the perfect hash layout, the keys are looked up in
+    // blocks, in three passes: the first hashes the keys and prefetches the
+    // seeds of their buckets, the second computes their slots and prefetches
+    // the keys and values there, and the third compares the keys. Thus, the
+    // cache misses of the lookups of a block overlap, instead of occurring
+    // one after the other, as with at() in a loop.
+    std::size_t lookup_batch(std::span<const KeyType> keys, std::span<ValueType> values) const
+    {
+        if (keys.size() != values.size())
+        {
+            throw std::invalid_argument(std::format("lookup_batch: {} keys, but {} values", keys.size(), values.size()));
+        }
+
+        std::size_t n_found = 0;
+        if constexpr (!is_perfect_hash)
+        {
+            for (std::size_t i = 0; i < keys.size(); i++)
+            {
+                if (const std::size_t idx = find_index(keys[i]); idx != Size)
+                {
+                    values[i] = values_[idx];
+                    n_found++;
+                }
+            }
+        }
+        else
+        {
+            // Enough lookups in flight to cover the latency of memory
+            constexpr std::size_t block_size = 32;
+            std::array<std::uint64_t, block_size> hashes;
+            std::array<std::size_t, block_size> slots;
+            for (std::size_t first = 0; first < keys.size(); first += block_size)
+            {
+                const std::size_t count = std::min(block_size, keys.size() - first);
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    hashes[i] = hash_key(keys[first + i]);
+                    __builtin_prefetch(&seeds_[hashes[i] % Size]);
+                }
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    slots[i] = perfect_hash_slot(hashes[i], seeds_);
+                    if constexpr (has_fingerprints)
+                    {
+                        __builtin_prefetch(&fingerprints_[slots[i]]);
+                    }
+                    __builtin_prefetch(&keys_[slots[i]]);
+                    __builtin_prefetch(&values_[slots[i]]);
+                }
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    if constexpr (has_fingerprints)
+                    {
+                        if (fingerprints_[slots[i]] != fingerprint(hashes[i]))
+                        {
+                            continue;
+                        }
+                    }
+                    if (keys_[slots[i]] == keys[first + i])
+                    {
+                        values[first + i] = values_[slots[i]];
+                        n_found++;
+                    }
+                }
+            }
+        }
+        return n_found;
+    }
+
+    // First pair whose key is not less than key, if any
+    constexpr std::optional<const_reference> lower_bound(const KeyType &key) const
+        requires is_eytzinger
+    {
+        const std::size_t pos = eytzinger_lower_bound(std::span<const KeyType>(keys_), key);
+        return pos == Size ? std::nullopt : std::optional<const_reference>(std::in_place, keys_[pos], values_[pos]);
+    }
+
+    // Call f(key, value) for the pairs with first <= key < last, in ascending order
+    template <typename F>
+    constexpr void for_each_in_range(const KeyType &first, const KeyType &last, F f) const
+        requires is_eytzinger
+    {
+        for (std::size_t pos = eytzinger_lower_bound(std::span<const KeyType>(keys_), first);
+             pos != Size && keys_[pos] < last;
+             pos = eytzinger_next(pos, Size))
+        {
+            f(keys_[pos], values_[pos]);
+        }
+    }
+
+private:
+    // Position of each pair, and the perfect hash function (if any)
+    struct Placement
+    {
+        // Index in data of the pair at each position
+        std::array<std::size_t, Size> order;
+        std::array<std::uint64_t, is_perfect_hash ? Size : 0> hashes;
+        std::array<std::uint32_t, is_perfect_hash ? Size : 0> seeds;
+    };
+
+    static constexpr Placement place(const std::array<value_type, Size> &data)
+    {
+        Placement placement{};
+        auto &[order, hashes, seeds] = placement;
+        if constexpr (is_perfect_hash)
+        {
+            std::ranges::transform(data, hashes.begin(), [](const auto &kv)
+                                   { return hash_key(kv.first); });
+
+            std::array<std::size_t, Size> slots;
+            build_perfect_hash(hashes, seeds, slots);
+            for (std::size_t i = 0; i < Size; i++)
+            {
+                order[slots[i]] = i;
+            }
+        }
+        else if constexpr (is_simd_scan)
+        {
+            std::iota(order.begin(), order.end(), std::size_t{0});
+        }
+        else
+        {
+            // Sort the indices rather than the pairs, which may be large
+            std::array<std::size_t, Size> sorted;
+            std::iota(sorted.begin(), sorted.end(), std::size_t{0});
+            auto key_of = [&data](std::size_t i) -> const KeyType &
+            {
+                return data[i].first;
+            };
+            std::ranges::sort(sorted, std::less<>{}, key_of);
+            if (std::ranges::adjacent_find(sorted, std::equal_to<>{}, key_of) != sorted.end())
+            {
+                throw std::invalid_argument("Duplicate keys in map");
+            }
+
+            std::array<std::size_t, Size> ranks;
+            build_eytzinger(ranks);
+            for (std::size_t pos = 0; pos < Size; pos++)
+            {
+                order[pos] = sorted[ranks[pos]];
+            }
+        }
+        return placement;
+    }
+
+    // Fill the arrays once the position of each pair is known
+    constexpr Map(const std::array<value_type, Size> &data, const Placement &placement)
+        : seeds_(placement.seeds), keys_{}, values_{}
+    {
+        for (std::size_t pos = 0; pos < Size; pos++)
+        {
+            const auto &[key, value] = data[placement.order[pos]];
+            keys_[pos] = to_stored(key);
+            values_[pos] = value;
+        }
+        finish(data, placement);
+    }
+
+    // Copy the keys and the values to their positions in place, with a pack
+    // of Size indices. GCC takes time quadratic in Size to optimize the
+    // unrolled copies, hence this is only done if it must be
+    template <std::size_t... Pos>
+    constexpr Map(const std::array<value_type, Size> &data, const Placement &placement, std::index_sequence<Pos...>)
+        : seeds_(placement.seeds),
+          keys_{{to_stored(data[placement.order[Pos]].first)...}},
+          values_{{data[placement.order[Pos]].second...}}
+    {
+        finish(data, placement);
+    }
+
+    // Store the fingerprints, and check the keys of the SIMD scan
+    constexpr void finish(const std::array<value_type, Size> &data, const Placement &placement)
+    {
+        if constexpr (has_fingerprints)
+        {
+            for (std::size_t pos = 0; pos < Size; pos++)
+            {
+                fingerprints_[pos] = fingerprint(placement.hashes[placement.order[pos]]);
+            }
+        }
+
+        if constexpr (is_simd_scan)
+        {
+            for (std::size_t i = 0; i < Size; i++)
+            {
+                if (find_index(data[i].first) != i)
+                {
+                    throw std::invalid_argument("Duplicate keys in map");
+                }
+            }
+        }
+    }
+
+    // Keys of the SIMD scan are stored as unsigned integers
+    static constexpr stored_key to_stored(const KeyType &key)
+    {
+        if constexpr (is_simd_scan)
+        {
+            return std::bit_cast<key_bits>(key);
+        }
+        else
+        {
+            return key;
+        }
+    }
+
+    static constexpr std::uint32_t fingerprint(std::uint64_t hash)
+    {
+        // The slot depends mostly on the low bits of the hash
+        return static_cast<std::uint32_t>(hash >> 32);
+    }
+
+    // Position of the pair with the given key (a KeyType, or a HashedKey),
+    // or Size if there is none
+    template <typename Key>
+    constexpr std::size_t find_index(const Key &key) const
+    {
+        if constexpr (std::is_same_v<Key, HashedKey> && !is_perfect_hash)
+        {
+            // Only the perfect hash uses the hash
+            return find_index(key.str());
+        }
+        else if constexpr (is_perfect_hash)
+        {
+            const std::uint64_t hash = hash_key(key);
+            const std::size_t slot = perfect_hash_slot(hash, seeds_);
+            if constexpr (has_fingerprints)
+            {
+                if (fingerprints_[slot] != fingerprint(hash))
+                {
+                    return Size;
+                }
+            }
+            return keys_[slot] == key ? slot : Size;
+        }
+        else if constexpr (is_simd_scan)
+        {
+            const auto needle = std::bit_cast<key_bits>(key);
+            if (std::is_constant_evaluated())
+            {
+                return static_cast<std::size_t>(std::ranges::find(keys_, needle) - keys_.begin());
+            }
+            return simd_find_key(keys_.data(), Size, needle);
+        }
+        else
+        {
+            const std::size_t pos = eytzinger_lower_bound(std::span<const KeyType>(keys_), key);
+            return pos != Size && keys_[pos] == key ? pos : Size;
+        }
+    }
+
+    std::array<std::uint32_t, is_perfect_hash ? Size : 0> seeds_{};
+    std::array<std::uint32_t, has_fingerprints ? Size : 0> fingerprints_{};
+    std::array<stored_key, Size> keys_;
+    std::array<ValueType, Size> values_;
+};
+
+// Deduce the template arguments of Map from an array of pairs
+template <typename KeyType, typename ValueType, std::size_t Size>
+Map(const std::array<std::pair<KeyType, ValueType>, Size> &) -> Map<KeyType, ValueType, Size>;
+
+// Swiss table groups
+// The control bytes of a FlatMap describe its slots: the sign bit is set for
+// an empty or deleted slot, otherwise the byte holds 7 bits of the hash of the
+// key in the slot. A lookup compares a group of 16 control bytes with these
+// bits at once (SSE2), and compares only the keys of the matching slots.
+namespace swiss
+{
+    constexpr std::size_t group_size = 16;
+    constexpr std::int8_t empty = -128; // 0b10000000
+    constexpr std::int8_t deleted = -2; // 0b11111110
+
+    // One bit per control byte of the group, set if the byte is equal to value
+    inline unsigned match(const std::int8_t *group, std::int8_t value)
+    {
+#if defined(__SSE2__)
+        const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+        unsigned mask = 0;
+        for (std::size_t i = 0; i < group_size; i++)
+        {
+            mask |= static_cast<unsigned>(group[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // One bit per control byte of the group, set if the slot is empty or deleted
+    inline unsigned match_free(const std::int8_t *group)
+    {
+#if defined(__SSE2__)
+        const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<unsigned>(_mm_movemask_epi8(ctrl));
+#else
+        unsigned mask = 0;
+        for (std::size_t i = 0; i < group_size; i++)
+        {
+            mask |= static_cast<unsigned>(group[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+}
+
+// The FlatMap class is a mutable hash map, whose size is not known at
+// compile time, unlike Map. The pairs are stored in a single array of slots
+// (open addressing), rather than in a node per pair, as in std::unordered_map,
+// so that a lookup does not chase pointers. The slots are split into groups
+// of 16, each with 16 control bytes (see swiss above). A lookup starts at the
+// group given by the hash of the key, and continues with the next groups of
+// a (triangular) probe sequence, until a group has an empty slot.
+// Erased slots are marked as deleted, so that they do not end the probe
+// sequences that pass over them, and are reused by later insertions.
+// Keys may be looked up by any type that hashes and compares equal to them,
+// e.g. std::string keys by std::string_view, without constructing a key.
+template <typename KeyType, typename ValueType>
+class FlatMap
+{
+    // Types by which keys can be looked up (heterogeneous lookup)
+    template <typename Key>
+    static constexpr bool hashable_as = requires(const Key &key, const KeyType &stored) {
+        hash_key(key);
+        { key == stored } -> std::convertible_to<bool>;
+    };
+
+public:
+    using value_type = std::pair<KeyType, ValueType>;
+
+    FlatMap() = default;
+
+    explicit FlatMap(std::size_t n)
+    {
+        reserve(n);
+    }
+
+    FlatMap(const FlatMap &other)
+    {
+        reserve(other.size_);
+        other.for_each([this](const KeyType &key, const ValueType &value)
+                       { insert(key, value); });
+    }
+
+    FlatMap(FlatMap &&other) noexcept
+        : ctrl_(std::move(other.ctrl_)),
+          slots_(std::exchange(other.slots_, nullptr)),
+          capacity_(std::exchange(other.capacity_, 0)),
+          size_(std::exchange(other.size_, 0)),
+          deleted_(std::exchange(other.deleted_, 0))
+    {
+    }
+
+    // Copy-and-swap
+    FlatMap &operator=(FlatMap other) noexcept
+    {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(deleted_, other.deleted_);
+        return *this;
+    }
+
+    ~FlatMap()
+    {
+        release();
+    }
+
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    // Make room for n pairs without rehashing
+    void reserve(std::size_t n)
+    {
+        if (n > max_size(capacity_))
+        {
+            rehash(capacity_for(n));
+        }
+    }
+
+    // Insert the pair, unless the key is already in the map.
+    // Returns a pointer to the value of the key, and whether it was inserted
+    std::pair<ValueType *, bool> insert(KeyType key, ValueType value)
+    {
+        const std::uint64_t hash = hash_of(key);
+        if (const std::size_t pos = find_index(key, hash); pos != capacity_)
+        {
+            return {&slots_[pos].second, false};
+        }
+
+        if (size_ + deleted_ + 1 > max_size(capacity_))
+        {
+            // Only drop the deleted slots if the pairs take up at most 25/32 of
+            // the slots (as Abseil does), and otherwise double the capacity.
+            // Either way, at least 3/32 of the slots are free afterwards, so
+            // that the cost of a rehash is amortized over as many insertions
+            if (size_ * 32 <= capacity_ * 25)
+            {
+                rehash(std::max(capacity_, capacity_for(size_ + 1)));
+            }
+            else
+            {
+                rehash(std::max(2 * capacity_, capacity_for(size_ + 1)));
+            }
+        }
+        const std::size_t pos = find_free_index(hash);
+        if (ctrl_[pos] == swiss::deleted)
+        {
+            deleted_--;
+        }
+        std::construct_at(&slots_[pos], std::move(key), std::move(value));
+        ctrl_[pos] = h2(hash);
+        size_++;
+        return {&slots_[pos].second, true};
+    }
+
+    // Erase the pair of the given key, if any. Returns whether it was erased
+    template <typename Key>
+        requires hashable_as<Key>
+    bool erase(const Key &key)
+    {
+        const std::size_t pos = find_index(key, hash_of(key));
+        if (pos == capacity_)
+        {
+            return false;
+        }
+        std::destroy_at(&slots_[pos]);
+        ctrl_[pos] = swiss::deleted;
+        size_--;
+        deleted_++;
+        return true;
+    }
+
+    // Value of the given key, or nullptr
+    template <typename Key>
+        requires hashable_as<Key>
+    ValueType *find(const Key &key)
+    {
+        const std::size_t pos = find_index(key, hash_of(key));
+        return pos == capacity_ ? nullptr : &slots_[pos].second;
+    }
+
+    template <typename Key>
+        requires hashable_as<Key>
+    const ValueType *find(const Key &key) const
+    {
+        const std::size_t pos = find_index(key, hash_of(key));
+        return pos == capacity_ ? nullptr : &slots_[pos].second;
+    }
+
+    template <typename Key>
+        requires hashable_as<Key>
+    bool contains(const Key &key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    template <typename Key>
+        requires hashable_as<Key>
+    const ValueType &at(const Key &key) const
+    {
+        const ValueType *value = find(key);
+        if (value == nullptr) [[unlikely]]
+        {
+            throw(std::range_error("Key not found in map.\n"));
+        }
+        return *value;
+    }
+
+    template <typename Key>
+        requires hashable_as<Key>
+    ValueType get_or(const Key &key, const ValueType &default_value) const
+    {
+        const ValueType *value = find(key);
+        return value == nullptr ? default_value : *value;
+    }
+
+    // Call f(key, value) for each pair, in no particular order
+    template <typename F>
+    void for_each(F f) const
+    {
+        for (std::size_t pos = 0; pos < capacity_; pos++)
+        {
+            if (ctrl_[pos] >= 0)
+            {
+                f(slots_[pos].first, slots_[pos].second);
+            }
+        }
+    }
+
+private:
+    // The hash of a string is mixed as well, since the low bits of FNV-1a,
+    // which select the first group, depend only on the low bits of the characters
+    template <typename Key>
+    static std::uint64_t hash_of(const Key &key)
+    {
+        return mix(hash_key(key));
+    }
+
+    // The low 7 bits are stored in the control byte, the rest select the first group
+    static std::int8_t h2(std::uint64_t hash)
+    {
+        return static_cast<std::int8_t>(hash & 0x7F);
+    }
+
+    std::size_t first_group(std::uint64_t hash) const
+    {
+        return (hash >> 7) & (capacity_ / swiss::group_size - 1);
+    }
+
+    // Maximum load factor 7/8
+    static std::size_t max_size(std::size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+    // Smallest capacity (a power of 2 number of groups) that holds n pairs
+    static std::size_t capacity_for(std::size_t n)
+    {
+        std::size_t capacity = swiss::group_size;
+        while (max_size(capacity) < n)
+        {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    // Slot of the given key, or capacity_ if there is none
+    template <typename Key>
+    std::size_t find_index(const Key &key, std::uint64_t hash) const
+    {
+        if (capacity_ == 0)
+        {
+            return capacity_;
+        }
+        const std::size_t group_mask = capacity_ / swiss::group_size - 1;
+        const std::int8_t tag = h2(hash);
+        std::size_t group = first_group(hash);
+        for (std::size_t step = 1;; step++)
+        {
+            const std::size_t first = group * swiss::group_size;
+            for (unsigned mask = swiss::match(&ctrl_[first], tag); mask != 0; mask &= mask - 1)
+            {
+                const std::size_t pos = first + std::countr_zero(mask);
+                if (key == slots_[pos].first) [[likely]]
+                {
+                    return pos;
+                }
+            }
+            // A key is inserted in the first free slot of its probe sequence,
+            // so an empty slot ends the sequence (unlike a deleted one)
+            if (swiss::match(&ctrl_[first], swiss::empty) != 0)
+            {
+                return capacity_;
+            }
+            // Visits every group, since the number of groups is a power of 2
+            group = (group + step) & group_mask;
+        }
+    }
+
+    // First empty or deleted slot in the probe sequence of the hash
+    std::size_t find_free_index(std::uint64_t hash) const
+    {
+        const std::size_t group_mask = capacity_ / swiss::group_size - 1;
+        std::size_t group = first_group(hash);
+        for (std::size_t step = 1;; step++)
+        {
+            const std::size_t first = group * swiss::group_size;
+            if (const unsigned mask = swiss::match_free(&ctrl_[first]); mask != 0)
+            {
+                return first + std::countr_zero(mask);
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    // Move the pairs to new_capacity slots
+    void rehash(std::size_t new_capacity)
+    {
+        FlatMap other;
+        other.ctrl_.assign(new_capacity, swiss::empty);
+        other.slots_ = std::allocator<value_type>{}.allocate(new_capacity);
+        other.capacity_ = new_capacity;
+        for (std::size_t pos = 0; pos < capacity_; pos++)
+        {
+            if (ctrl_[pos] >= 0)
+            {
+                const std::uint64_t hash = hash_of(slots_[pos].first);
+                const std::size_t new_pos = other.find_free_index(hash);
+                std::construct_at(&other.slots_[new_pos], std::move(slots_[pos]));
+                other.ctrl_[new_pos] = h2(hash);
+                other.size_++;
+            }
+        }
+        *this = std::move(other);
+    }
+
+    void release()
+    {
+        for (std::size_t pos = 0; pos < capacity_; pos++)
+        {
+            if (ctrl_[pos] >= 0)
+            {
+                std::destroy_at(&slots_[pos]);
+            }
+        }
+        if (slots_ != nullptr)
+        {
+            std::allocator<value_type>{}.deallocate(slots_, capacity_);
+        }
+    }
+
+    std::vector<std::int8_t> ctrl_;
+    value_type *slots_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+    std::size_t deleted_ = 0;
+};
+
+// Layout of a FrozenMap, chosen by FrozenMap::build unless given explicitly
+enum class FrozenLayout : std::uint32_t
+{
+    automatic,
+    perfect_hash,
+    eytzinger
+};
+
+// The FrozenMap class is an immutable map, like Map, whose size is only known
+// at runtime, e.g. a table that is loaded once at startup and then queried
+// many times. It is built from the pairs of any container, with either the
+// perfect hash or the Eytzinger layout of Map, and is stored in a single
+// contiguous binary blob:
+//   header | seeds (perfect hash only) | keys | values
+// Integer keys are stored as they are, and string keys as the offsets of
+// their characters, which follow the offsets. The blob can be saved to a
+// file, and later mapped into memory (mmap) and queried in place, without
+// rebuilding the map, or even reading the pages that are never queried.
+// Hence the values must be trivially copyable, and the keys either integers
+// or (stored) strings, which are looked up by std::string_view. The blob has
+// the byte order of the machine that built it.
+template <typename KeyType, typename ValueType>
+class FrozenMap
+{
+    static constexpr bool is_string_key = std::is_same_v<KeyType, std::string_view>;
+    static_assert(is_string_key || std::is_integral_v<KeyType> || std::is_enum_v<KeyType>,
+                  "FrozenMap keys must be integers or std::string_view");
+    static_assert(std::is_trivially_copyable_v<ValueType>, "FrozenMap values must be trivially copyable");
+    // Alignment of the blob, as allocated by std::vector or mapped by mmap
+    static constexpr std::size_t max_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    static_assert(alignof(ValueType) <= max_alignment, "FrozenMap values are over-aligned");
+
+    struct Header
+    {
+        std::uint64_t magic;
+        std::uint32_t version;
+        FrozenLayout layout;
+        std::uint64_t size;
+        std::uint64_t key_size; // 0 for string keys
+        std::uint64_t value_size;
+        std::uint64_t chars_size;
+    };
+
+    static constexpr std::uint64_t magic = 0x50414d4e455a4f52; // "ROZENMAP"
+    static constexpr std::uint32_t version = 2;
+    // Alignment of the keys, or of the offsets of the string keys
+    static constexpr std::size_t keys_alignment = is_string_key ? alignof(std::uint64_t) : alignof(KeyType);
+
+public:
+    // Size of the header of the blob, which the seeds follow
+    static constexpr std::size_t header_size = sizeof(Header);
+
+    // Build from the (key, value) pairs of a container, e.g. a std::unordered_map
+    // or a std::vector of pairs. Throws std::invalid_argument on duplicate keys,
+    // which both layouts detect before building anything (the perfect hash with
+    // the same check as Map, see build_perfect_hash)
+    template <std::ranges::input_range R>
+    static FrozenMap build(const R &pairs, FrozenLayout layout = FrozenLayout::automatic)
+    {
+        std::vector<KeyType> keys;
+        std::vector<ValueType> values;
+        for (const auto &[key, value] : pairs)
+        {
+            keys.emplace_back(key);
+            values.emplace_back(value);
+        }
+        const std::size_t n = keys.size();
+        if (layout == FrozenLayout::automatic)
+        {
+            layout = choose_layout(keys);
+        }
+
+        // Index in pairs of the pair at each position
+        std::vector<std::size_t> order(n);
+        std::vector<std::uint32_t> seeds;
+        if (layout == FrozenLayout::perfect_hash)
+        {
+            std::vector<std::uint64_t> hashes(n);
+            std::ranges::transform(keys, hashes.begin(), [](const KeyType &key)
+                                   { return hash_key(key); });
+            seeds.resize(n);
+            std::vector<std::size_t> slots(n);
+            if (n > 0)
+            {
+                build_perfect_hash(hashes, seeds, slots);
+            }
+            for (std::size_t i = 0; i < n; i++)
+            {
+                order[slots[i]] = i;
+            }
+        }
+        else
+        {
+            std::vector<std::size_t> sorted(n);
+            std::iota(sorted.begin(), sorted.end(), std::size_t{0});
+            auto key_of = [&keys](std::size_t i)
+            {
+                return keys[i];
+            };
+            std::ranges::sort(sorted, std::less<>{}, key_of);
+            if (std::ranges::adjacent_find(sorted, std::equal_to<>{}, key_of) != sorted.end())
+            {
+                throw std::invalid_argument("Duplicate keys in map");
+            }
+            std::vector<std::size_t> ranks(n);
+            build_eytzinger(ranks);
+            for (std::size_t pos = 0; pos < n; pos++)
+            {
+                order[pos] = sorted[ranks[pos]];
+            }
+        }
+
+        // Serialize
+        Header header{magic, version, layout, n, is_string_key ? 0 : sizeof(KeyType), sizeof(ValueType), 0};
+        std::vector<std::uint64_t> offsets;
+        if constexpr (is_string_key)
+        {
+            offsets.reserve(n + 1);
+            for (std::size_t pos = 0; pos < n; pos++)
+            {
+                offsets.push_back(header.chars_size);
+                header.chars_size += keys[order[pos]].size();
+            }
+            offsets.push_back(header.chars_size);
+        }
+
+        std::vector<std::byte> blob;
+        append(blob, &header, sizeof(header));
+        append(blob, seeds.data(), seeds.size() * sizeof(std::uint32_t));
+        blob.resize(align_up(blob.size(), keys_alignment));
+        if constexpr (is_string_key)
+        {
+            append(blob, offsets.data(), offsets.size() * sizeof(std::uint64_t));
+            for (std::size_t pos = 0; pos < n; pos++)
+            {
+                append(blob, keys[order[pos]].data(), keys[order[pos]].size());
+            }
+        }
+        else
+        {
+            for (std::size_t pos = 0; pos < n; pos++)
+            {
+                append(blob, &keys[order[pos]], sizeof(KeyType));
+            }
+        }
+        blob.resize(align_up(blob.size(), alignof(ValueType)));
+        for (std::size_t pos = 0; pos < n; pos++)
+        {
+            append(blob, &values[order[pos]], sizeof(ValueType));
+        }
+        return FrozenMap(std::move(blob));
+    }
+
+    // Take ownership of a blob created by build (e.g. read from a file)
+    explicit FrozenMap(std::vector<std::byte> blob)
+        : owned_(std::move(blob))
     {
+        parse(owned_);
     }
 
-    constexpr ValueType at(const KeyType &key) const
+    // Map a blob saved by save() into memory, read-only
+    static FrozenMap load(const std::filesystem::path &path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            throw std::system_error(errno, std::generic_category(), std::format("Could not open {}", path.string()));
+        }
+
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) == -1)
+        {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), std::format("Could not stat {}", path.string()));
+        }
+
+        FrozenMap map;
+        map.mapping_size_ = static_cast<std::size_t>(file_stat.st_size);
+        void *addr = map.mapping_size_ > 0 ? ::mmap(nullptr, map.mapping_size_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (addr == MAP_FAILED)
+        {
+            const int error = map.mapping_size_ > 0 ? errno : EINVAL;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), std::format("Could not map {}", path.string()));
+        }
+        map.mapping_ = addr;
+
+        // The mapping remains valid after the file is closed
+        ::close(fd);
+        map.parse({static_cast<const std::byte *>(addr), map.mapping_size_});
+        return map;
+    }
+
+    void save(const std::filesystem::path &path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(blob_.data()), static_cast<std::streamsize>(blob_.size()));
+        if (!file)
+        {
+            throw std::runtime_error(std::format("Could not write {}", path.string()));
+        }
+    }
+
+    ~FrozenMap()
+    {
+        if (mapping_ != nullptr)
+        {
+            ::munmap(mapping_, mapping_size_);
+        }
+    }
+
+    FrozenMap(const FrozenMap &) = delete;
+    FrozenMap &operator=(const FrozenMap &) = delete;
+
+    // The views into the blob remain valid, since neither the storage of
+    // the vector nor the mapping move
+    FrozenMap(FrozenMap &&other) noexcept
+        : owned_(std::move(other.owned_)),
+          mapping_(std::exchange(other.mapping_, nullptr)),
+          mapping_size_(std::exchange(other.mapping_size_, 0)),
+          blob_(std::exchange(other.blob_, {})),
+          layout_(other.layout_),
+          seeds_(std::exchange(other.seeds_, {})),
+          keys_(std::exchange(other.keys_, {})),
+          offsets_(std::exchange(other.offsets_, {})),
+          chars_(std::exchange(other.chars_, nullptr)),
+          values_(std::exchange(other.values_, {}))
+    {
+    }
+
+    FrozenMap &operator=(FrozenMap &&other) noexcept
+    {
+        std::swap(owned_, other.owned_);
+        std::swap(mapping_, other.mapping_);
+        std::swap(mapping_size_, other.mapping_size_);
+        std::swap(blob_, other.blob_);
+        std::swap(layout_, other.layout_);
+        std::swap(seeds_, other.seeds_);
+        std::swap(keys_, other.keys_);
+        std::swap(offsets_, other.offsets_);
+        std::swap(chars_, other.chars_);
+        std::swap(values_, other.values_);
+        return *this;
+    }
+
+    std::size_t size() const { return values_.size(); }
+    FrozenLayout layout() const { return layout_; }
+
+    // The serialized map
+    std::span<const std::byte> bytes() const { return blob_; }
+
+    // Value of the given key, or nullptr
+    const ValueType *find(const KeyType &key) const
+    {
+        const std::size_t pos = find_index(key);
+        return pos == size() ? nullptr : &values_[pos];
+    }
+
+    bool contains(const KeyType &key) const
     {
-        const auto it = std::find_if(data_.cbegin(), data_.cend(),
-                                     [&key](const auto &kv)
-                                     { return kv.first == key; });
+        return find_index(key) != size();
+    }
 
-        if (it == data_.end())
+    const ValueType &at(const KeyType &key) const
+    {
+        const ValueType *value = find(key);
+        if (value == nullptr) [[unlikely]]
         {
-            throw(std::range_error(std::format("{} not found in map.\n", key)));
+            throw(std::range_error("Key not found in map.\n"));
         }
+        return *value;
+    }
 
-        return it->second;
+    ValueType get_or(const KeyType &key, const ValueType &default_value) const
+    {
+        const ValueType *value = find(key);
+        return value == nullptr ? default_value : *value;
     }
 
 private:
-    std::array<std::pair<KeyType, ValueType>, Size> data_;
+    FrozenMap() = default;
+
+    static std::size_t align_up(std::size_t n, std::size_t alignment)
+    {
+        return (n + alignment - 1) / alignment * alignment;
+    }
+
+    static void append(std::vector<std::byte> &blob, const void *data, std::size_t n)
+    {
+        const auto *bytes = static_cast<const std::byte *>(data);
+        blob.insert(blob.end(), bytes, bytes + n);
+    }
+
+    // A lookup in the perfect hash layout hashes the whole key, while one in
+    // the Eytzinger layout compares it with log2(n) keys, which usually
+    // differ from it in their first few characters. Thus, the Eytzinger
+    // layout is faster for long string keys, in a small map
+    static FrozenLayout choose_layout(const std::vector<KeyType> &keys)
+    {
+        if constexpr (is_string_key)
+        {
+            if (!keys.empty())
+            {
+                std::size_t n_chars = 0;
+                for (const auto &key : keys)
+                {
+                    n_chars += key.size();
+                }
+                if (n_chars / keys.size() >= 16 * static_cast<std::size_t>(std::bit_width(keys.size())))
+                {
+                    return FrozenLayout::eytzinger;
+                }
+            }
+        }
+        return FrozenLayout::perfect_hash;
+    }
+
+    // Set the views into the blob, after checking that they fit in it
+    void parse(std::span<const std::byte> blob)
+    {
+        auto invalid = [](const char *what)
+        {
+            return std::invalid_argument(std::format("Invalid FrozenMap blob: {}", what));
+        };
+
+        if (blob.size() < sizeof(Header))
+        {
+            throw invalid("too small");
+        }
+        Header header;
+        std::memcpy(&header, blob.data(), sizeof(Header));
+        if (header.magic != magic || header.version != version)
+        {
+            throw invalid("bad magic number or version");
+        }
+        if (header.key_size != (is_string_key ? 0 : sizeof(KeyType)) || header.value_size != sizeof(ValueType))
+        {
+            throw invalid("key or value type mismatch");
+        }
+        if (header.layout != FrozenLayout::perfect_hash && header.layout != FrozenLayout::eytzinger)
+        {
+            throw invalid("unknown layout");
+        }
+
+        const std::size_t n = header.size;
+        std::size_t offset = sizeof(Header);
+        const std::size_t seeds_offset = offset;
+        offset += header.layout == FrozenLayout::perfect_hash ? n * sizeof(std::uint32_t) : 0;
+        const std::size_t keys_offset = align_up(offset, keys_alignment);
+        offset = keys_offset;
+        offset += is_string_key ? (n + 1) * sizeof(std::uint64_t) + header.chars_size : n * sizeof(KeyType);
+        const std::size_t values_offset = align_up(offset, alignof(ValueType));
+        if (n > blob.size() || header.chars_size > blob.size() || values_offset + n * sizeof(ValueType) > blob.size())
+        {
+            throw invalid("truncated");
+        }
+
+        // The sections are (implicitly) created as arrays of trivial types
+        // by memcpy or mmap, so they are read in place
+        blob_ = blob;
+        layout_ = header.layout;
+        seeds_ = {reinterpret_cast<const std::uint32_t *>(blob.data() + seeds_offset),
+                  layout_ == FrozenLayout::perfect_hash ? n : 0};
+        // perfect_hash_slot wraps the slot around at most once, so a larger
+        // displacement would index past the keys
+        if (std::ranges::any_of(seeds_, [n](std::uint32_t seed)
+                                { return (seed & 0xFFFFFF) >= n; }))
+        {
+            throw invalid("bad seeds");
+        }
+        if constexpr (is_string_key)
+        {
+            offsets_ = {reinterpret_cast<const std::uint64_t *>(blob.data() + keys_offset), n + 1};
+            chars_ = reinterpret_cast<const char *>(blob.data() + keys_offset + (n + 1) * sizeof(std::uint64_t));
+            if (offsets_[0] != 0 || !std::ranges::is_sorted(offsets_) || offsets_[n] != header.chars_size)
+            {
+                throw invalid("bad key offsets");
+            }
+        }
+        else
+        {
+            keys_ = {reinterpret_cast<const KeyType *>(blob.data() + keys_offset), n};
+        }
+        values_ = {reinterpret_cast<const ValueType *>(blob.data() + values_offset), n};
+    }
+
+    KeyType key_at(std::size_t pos) const
+    {
+        if constexpr (is_string_key)
+        {
+            return {chars_ + offsets_[pos], offsets_[pos + 1] - offsets_[pos]};
+        }
+        else
+        {
+            return keys_[pos];
+        }
+    }
+
+    // Position of the pair with the given key, or size() if there is none
+    std::size_t find_index(const KeyType &key) const
+    {
+        const std::size_t n = size();
+        if (n == 0)
+        {
+            return n;
+        }
+        if (layout_ == FrozenLayout::perfect_hash)
+        {
+            const std::size_t slot = perfect_hash_slot(hash_key(key), seeds_);
+            return key_at(slot) == key ? slot : n;
+        }
+        std::size_t pos;
+        if constexpr (is_string_key)
+        {
+            // Search the offsets, projected to the keys that start at them
+            pos = eytzinger_lower_bound(offsets_.first(n), key, [this](const std::uint64_t &offset)
+                                        { return key_at(&offset - offsets_.data()); });
+        }
+        else
+        {
+            pos = eytzinger_lower_bound(keys_, key);
+        }
+        return pos != n && key_at(pos) == key ? pos : n;
+    }
+
+    std::vector<std::byte> owned_;
+    void *mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+
+    // Views into the blob
+    std::span<const std::byte> blob_;
+    FrozenLayout layout_ = FrozenLayout::perfect_hash;
+    std::span<const std::uint32_t> seeds_;
+    std::span<const KeyType> keys_;
+    std::span<const std::uint64_t> offsets_;
+    const char *chars_ = nullptr;
+    std::span<const ValueType> values_;
 };
 
+// Compare the lookup time of the perfect hash and the Eytzinger layout
+// with a linear scan over the pairs (i.e. the former implementation of
+// Map::at), for a Map with Size keys
+template <std::size_t Size>
+void benchmark_lookup()
+{
+    constexpr std::size_t n_lookups = 1'000'000;
+
+    auto data = std::make_unique<std::array<std::pair<std::string, int>, Size>>();
+    for (std::size_t i = 0; i < Size; i++)
+    {
+        (*data)[i] = {std::format("key_{}", i), static_cast<int>(i)};
+    }
+    auto map = std::make_unique<Map<std::string, int, Size>>(*data);
+    auto sorted_map = std::make_unique<Map<std::string, int, Size, EytzingerLayout>>(*data);
+
+    // Keys to look up, in random order
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> dist(0, Size - 1);
+    std::vector<std::string> keys(n_lookups);
+    std::ranges::generate(keys, [&]
+                          { return (*data)[dist(gen)].first; });
+
+    auto time_lookups = [&keys](auto lookup)
+    {
+        long sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &key : keys)
+        {
+            sum += lookup(key);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::pair{std::chrono::duration<double, std::nano>(stop - start).count() / n_lookups, sum};
+    };
+
+    auto [linear_ns, linear_sum] = time_lookups([&data](const std::string &key)
+                                                { return std::find_if(data->cbegin(), data->cend(), [&key](const auto &kv)
+                                                                      { return kv.first == key; })
+                                                      ->second; });
+    auto [hash_ns, hash_sum] = time_lookups([&map](const std::string &key)
+                                            { return map->at(key); });
+    auto [eytzinger_ns, eytzinger_sum] = time_lookups([&sorted_map](const std::string &key)
+                                                      { return sorted_map->at(key); });
+
+    std::cout << std::format("Size: {:>5}, linear scan: {:>8.2f} ns, perfect hash: {:>6.2f} ns, eytzinger: {:>6.2f} ns{}\n",
+                             Size, linear_ns, hash_ns, eytzinger_ns,
+                             linear_sum == hash_sum && linear_sum == eytzinger_sum ? "" : " (mismatch)");
+}
+
+// Compare the lookup time of the SIMD key scan with the perfect hash and the
+// Eytzinger layout, for a small Map with Size integer keys, when a fraction
+// hot_ratio of the lookups is of the first 4 keys
+template <std::size_t Size>
+void benchmark_small_lookup(double hot_ratio)
+{
+    constexpr std::size_t n_lookups = 10'000'000;
+
+    // Scattered keys, so that the scan cannot be replaced by arithmetic
+    std::array<std::pair<std::uint32_t, int>, Size> data;
+    for (std::size_t i = 0; i < Size; i++)
+    {
+        data[i] = {static_cast<std::uint32_t>(mix(i)), static_cast<int>(i)};
+    }
+    const Map<std::uint32_t, int, Size> map(data);
+    const Map<std::uint32_t, int, Size, EytzingerLayout> sorted_map(data);
+    const Map<std::uint32_t, int, Size, SimdScanLayout> scan_map(data);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> dist(0, Size - 1);
+    std::uniform_int_distribution<std::size_t> hot_dist(0, std::min(Size, std::size_t{4}) - 1);
+    std::bernoulli_distribution hot(hot_ratio);
+    std::vector<std::uint32_t> keys(n_lookups);
+    std::ranges::generate(keys, [&]
+                          { return data[hot(gen) ? hot_dist(gen) : dist(gen)].first; });
+
+    auto time_lookups = [&keys](const auto &map)
+    {
+        long sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto key : keys)
+        {
+            sum += map.at(key);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::pair{std::chrono::duration<double, std::nano>(stop - start).count() / n_lookups, sum};
+    };
+
+    auto [hash_ns, hash_sum] = time_lookups(map);
+    auto [eytzinger_ns, eytzinger_sum] = time_lookups(sorted_map);
+    auto [scan_ns, scan_sum] = time_lookups(scan_map);
+
+    std::cout << std::format("Size: {:>5}, hot: {:>3.0f}%, perfect hash: {:>6.2f} ns, eytzinger: {:>6.2f} ns, simd scan: {:>6.2f} ns{}\n",
+                             Size, 100 * hot_ratio, hash_ns, eytzinger_ns, scan_ns,
+                             hash_sum == eytzinger_sum && hash_sum == scan_sum ? "" : " (mismatch)");
+}
+
+// Compare the lookup time of at(), which throws on a miss, with the
+// non-throwing lookups, when a given fraction of the keys is missing
+template <std::size_t Size>
+void benchmark_misses(double miss_ratio)
+{
+    constexpr std::size_t n_lookups = 100'000;
+
+    auto data = std::make_unique<std::array<std::pair<std::string, int>, Size>>();
+    for (std::size_t i = 0; i < Size; i++)
+    {
+        (*data)[i] = {std::format("key_{}", i), static_cast<int>(i)};
+    }
+    auto map = std::make_unique<Map<std::string, int, Size>>(*data);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> dist(0, Size - 1);
+    std::bernoulli_distribution miss(miss_ratio);
+    std::vector<std::string> keys(n_lookups);
+    std::ranges::generate(keys, [&]
+                          { return miss(gen) ? std::format("missing_{}", dist(gen)) : (*data)[dist(gen)].first; });
+
+    auto time_lookups = [&keys](auto lookup)
+    {
+        long sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &key : keys)
+        {
+            sum += lookup(key);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::pair{std::chrono::duration<double, std::nano>(stop - start).count() / n_lookups, sum};
+    };
+
+    auto [at_ns, at_sum] = time_lookups([&map](const std::string &key)
+                                        {
+                                            try
+                                            {
+                                                return map->at(key);
+                                            }
+                                            catch (const std::range_error &)
+                                            {
+                                                return -1;
+                                            } });
+    auto [find_ns, find_sum] = time_lookups([&map](const std::string &key)
+                                            {
+                                                const int *value = map->find(key);
+                                                return value ? *value : -1; });
+    auto [get_or_ns, get_or_sum] = time_lookups([&map](const std::string &key)
+                                                { return map->get_or(key, -1); });
+    auto [get_ns, get_sum] = time_lookups([&map](const std::string &key)
+                                          { return map->get(key).value_or(-1); });
+
+    std::cout << std::format("Misses: {:>3.0f}%, at + catch: {:>8.2f} ns, find: {:>6.2f} ns, get_or: {:>6.2f} ns, get: {:>6.2f} ns{}\n",
+                             100 * miss_ratio, at_ns, find_ns, get_or_ns, get_ns,
+                             at_sum == find_sum && at_sum == get_or_sum && at_sum == get_sum ? "" : " (mismatch)");
+}
+
+// Compare the lookup time of the Eytzinger layout with keys and values stored
+// separately (as in Map), and with the pairs stored together, for values of
+// ValueBytes bytes. With the pairs stored together, each probe of the search
+// reads a different cache line, which holds a single key, whereas with the keys
+// stored separately, the probes read the keys alone, which share cache lines
+// and fit in a faster cache.
+template <std::size_t ValueBytes>
+void benchmark_value_size()
+{
+    constexpr std::size_t Size = 16384;
+    constexpr std::size_t n_lookups = 1'000'000;
+
+    struct Value
+    {
+        std::array<std::uint64_t, ValueBytes / sizeof(std::uint64_t)> words;
+    };
+    using Pair = std::pair<std::uint64_t, Value>;
+
+    auto data = std::make_unique<std::array<Pair, Size>>();
+    for (std::size_t i = 0; i < Size; i++)
+    {
+        (*data)[i].first = mix(i);
+        (*data)[i].second.words.fill(i);
+    }
+    auto map = std::make_unique<Map<std::uint64_t, Value, Size, EytzingerLayout>>(*data);
+
+    // The pairs, sorted by key, in Eytzinger layout
+    std::vector<Pair> sorted(data->begin(), data->end());
+    std::ranges::sort(sorted, std::less<>{}, &Pair::first);
+    std::vector<std::size_t> ranks(Size);
+    build_eytzinger(ranks);
+    std::vector<Pair> pairs(Size);
+    for (std::size_t pos = 0; pos < Size; pos++)
+    {
+        pairs[pos] = sorted[ranks[pos]];
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> dist(0, Size - 1);
+    std::vector<std::uint64_t> keys(n_lookups);
+    std::ranges::generate(keys, [&]
+                          { return (*data)[dist(gen)].first; });
+
+    auto time_lookups = [&keys](auto lookup)
+    {
+        std::uint64_t sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto key : keys)
+        {
+            sum += lookup(key);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::pair{std::chrono::duration<double, std::nano>(stop - start).count() / n_lookups, sum};
+    };
+
+    auto [pairs_ns, pairs_sum] = time_lookups([&pairs](std::uint64_t key)
+                                              {
+                                                  const std::size_t pos = eytzinger_lower_bound(std::span<const Pair>(pairs), key, &Pair::first);
+                                                  return pairs[pos].second.words[0]; });
+    auto [map_ns, map_sum] = time_lookups([&map](std::uint64_t key)
+                                          { return map->at(key).words[0]; });
+
+    std::cout << std::format("Value size: {:>4} B, pairs together: {:>6.2f} ns, keys separate: {:>6.2f} ns{}\n",
+                             ValueBytes, pairs_ns, map_ns, pairs_sum == map_sum ? "" : " (mismatch)");
+}
+
+// Compare FlatMap with std::unordered_map, and with Map, for Size string keys:
+// the time per insertion (for Map, per key of the construction), and per
+// lookup of keys that are present (hits) and missing (misses)
+template <std::size_t Size>
+void benchmark_flat_map()
+{
+    constexpr std::size_t n_lookups = 1'000'000;
+
+    auto data = std::make_unique<std::array<std::pair<std::string, int>, Size>>();
+    for (std::size_t i = 0; i < Size; i++)
+    {
+        (*data)[i] = {std::format("key_{}", i), static_cast<int>(i)};
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> dist(0, Size - 1);
+    std::vector<std::string> hits(n_lookups);
+    std::ranges::generate(hits, [&]
+                          { return (*data)[dist(gen)].first; });
+    std::vector<std::string> misses(n_lookups);
+    std::ranges::generate(misses, [&]
+                          { return std::format("missing_{}", dist(gen)); });
+
+    auto time_per = [](std::size_t n, auto f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count() / n;
+    };
+
+    // Insertions
+    FlatMap<std::string, int> flat_map;
+    std::unordered_map<std::string, int> unordered_map;
+    std::unique_ptr<Map<std::string, int, Size>> map;
+    const double flat_insert_ns = time_per(Size, [&]
+                                           {
+                                               for (const auto &[key, value] : *data)
+                                               {
+                                                   flat_map.insert(key, value);
+                                               } });
+    const double unordered_insert_ns = time_per(Size, [&]
+                                                {
+                                                    for (const auto &[key, value] : *data)
+                                                    {
+                                                        unordered_map.emplace(key, value);
+                                                    } });
+    const double map_insert_ns = time_per(Size, [&]
+                                          { map = std::make_unique<Map<std::string, int, Size>>(*data); });
+
+    // Lookups, which return -1 on a miss
+    long flat_sum = 0;
+    long unordered_sum = 0;
+    long map_sum = 0;
+    auto time_lookups = [&](const std::vector<std::string> &keys)
+    {
+        return std::array{time_per(n_lookups, [&]
+                                   {
+                                       for (const auto &key : keys)
+                                       {
+                                           flat_sum += flat_map.get_or(key, -1);
+                                       } }),
+                          time_per(n_lookups, [&]
+                                   {
+                                       for (const auto &key : keys)
+                                       {
+                                           auto it = unordered_map.find(key);
+                                           unordered_sum += it == unordered_map.end() ? -1 : it->second;
+                                       } }),
+                          time_per(n_lookups, [&]
+                                   {
+                                       for (const auto &key : keys)
+                                       {
+                                           map_sum += map->get_or(key, -1);
+                                       } })};
+    };
+    const auto hit_ns = time_lookups(hits);
+    const auto miss_ns = time_lookups(misses);
+
+    const bool match = flat_sum == unordered_sum && flat_sum == map_sum;
+    std::cout << std::format("Size: {:>5}{}\n", Size, match ? "" : " (mismatch)");
+    std::cout << std::format("  {:<14} {:>8} {:>8} {:>8}\n", "", "insert", "hit", "miss");
+    std::cout << std::format("  {:<14} {:>8.2f} {:>8.2f} {:>8.2f}\n", "FlatMap", flat_insert_ns, hit_ns[0], miss_ns[0]);
+    std::cout << std::format("  {:<14} {:>8.2f} {:>8.2f} {:>8.2f}\n", "unordered_map", unordered_insert_ns, hit_ns[1], miss_ns[1]);
+    std::cout << std::format("  {:<14} {:>8.2f} {:>8.2f} {:>8.2f}\n", "Map", map_insert_ns, hit_ns[2], miss_ns[2]);
+}
+
+// Compare the lookup time of the layouts of FrozenMap, for n string keys of
+// key_length characters, and show which one FrozenMap::build chooses
+void benchmark_frozen_layouts(std::size_t n, std::size_t key_length)
+{
+    constexpr std::size_t n_lookups = 1'000'000;
+
+    // Random keys, which differ in their first few characters
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::vector<std::pair<std::string, int>> pairs(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        pairs[i].first.resize(key_length);
+        std::ranges::generate(pairs[i].first, [&]
+                              { return static_cast<char>(letter(gen)); });
+        pairs[i].second = static_cast<int>(i);
+    }
+    std::uniform_int_distribution<std::size_t> dist(0, n - 1);
+    std::vector<std::string_view> keys(n_lookups);
+    std::ranges::generate(keys, [&]
+                          { return std::string_view(pairs[dist(gen)].first); });
+
+    auto time_lookups = [&keys](FrozenLayout layout, const auto &pairs)
+    {
+        const auto map = FrozenMap<std::string_view, int>::build(pairs, layout);
+        long sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto key : keys)
+        {
+            sum += map.at(key);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::pair{std::chrono::duration<double, std::nano>(stop - start).count() / n_lookups, sum};
+    };
+
+    auto [hash_ns, hash_sum] = time_lookups(FrozenLayout::perfect_hash, pairs);
+    auto [eytzinger_ns, eytzinger_sum] = time_lookups(FrozenLayout::eytzinger, pairs);
+    const bool chose_hash = FrozenMap<std::string_view, int>::build(pairs).layout() == FrozenLayout::perfect_hash;
+
+    std::cout << std::format("Size: {:>5}, key length: {:>3}, perfect hash: {:>6.2f} ns, eytzinger: {:>6.2f} ns, chosen: {}{}\n",
+                             n, key_length, hash_ns, eytzinger_ns, chose_hash ? "perfect hash" : "eytzinger",
+                             hash_sum == eytzinger_sum ? "" : " (mismatch)");
+}
+
+// Compare the time to build a FrozenMap of n keys with the time to map a
+// saved one into memory
+void benchmark_frozen_load(std::size_t n)
+{
+    std::unordered_map<std::string, int> table;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        table.emplace(std::format("key_{}", i), static_cast<int>(i));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const auto built = FrozenMap<std::string_view, int>::build(table);
+    auto stop = std::chrono::steady_clock::now();
+    const double build_ms = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    const auto path = std::filesystem::temp_directory_path() / "frozen_map.bin";
+    built.save(path);
+    start = std::chrono::steady_clock::now();
+    const auto loaded = FrozenMap<std::string_view, int>::load(path);
+    stop = std::chrono::steady_clock::now();
+    const double load_ms = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    const bool match = std::ranges::all_of(table, [&loaded](const auto &kv)
+                                           { return loaded.at(kv.first) == kv.second; });
+    std::filesystem::remove(path);
+
+    std::cout << std::format("Size: {:>7}, blob: {:>6} KiB, build: {:>8.3f} ms, load: {:>6.3f} ms{}\n",
+                             n, built.bytes().size() / 1024, build_ms, load_ms, match ? "" : " (mismatch)");
+}
+
+// Compare looking up the same string keys in n_maps maps with Size keys each,
+// by std::string (hashed by each lookup), and by HashedKey (hashed once)
+template <std::size_t Size>
+void benchmark_hashed_keys(std::size_t n_maps, std::size_t key_length)
+{
+    constexpr std::size_t n_lookups = 1'000'000;
+
+    // The maps have the same keys, with different values
+    std::vector<std::unique_ptr<Map<std::string, int, Size>>> maps;
+    auto data = std::make_unique<std::array<std::pair<std::string, int>, Size>>();
+    for (std::size_t m = 0; m < n_maps; m++)
+    {
+        for (std::size_t i = 0; i < Size; i++)
+        {
+            (*data)[i] = {std::format("{:0>{}}", i, key_length), static_cast<int>(m * Size + i)};
+        }
+        maps.push_back(std::make_unique<Map<std::string, int, Size>>(*data));
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> dist(0, Size - 1);
+    std::vector<std::string> keys(n_lookups);
+    std::ranges::generate(keys, [&]
+                          { return (*data)[dist(gen)].first; });
+
+    auto time_lookups = [&keys](auto lookup)
+    {
+        long sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &key : keys)
+        {
+            sum += lookup(key);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::pair{std::chrono::duration<double, std::nano>(stop - start).count() / n_lookups, sum};
+    };
+
+    auto [string_ns, string_sum] = time_lookups([&maps](const std::string &key)
+                                                {
+                                                    long sum = 0;
+                                                    for (const auto &map : maps)
+                                                    {
+                                                        sum += map->at(key);
+                                                    }
+                                                    return sum; });
+    auto [hashed_ns, hashed_sum] = time_lookups([&maps](const std::string &key)
+                                                {
+                                                    const HashedKey hashed_key(key);
+                                                    long sum = 0;
+                                                    for (const auto &map : maps)
+                                                    {
+                                                        sum += map->at(hashed_key);
+                                                    }
+                                                    return sum; });
+
+    std::cout << std::format("Maps: {}, key length: {:>3}, std::string: {:>7.2f} ns, HashedKey: {:>7.2f} ns{}\n",
+                             n_maps, key_length, string_ns, hashed_ns, string_sum == hashed_sum ? "" : " (mismatch)");
+}
+
+// Compare looking up keys in a Map with Size keys one by one, with at(), and
+// in a batch, with lookup_batch()
+template <std::size_t Size>
+void benchmark_lookup_batch()
+{
+    constexpr std::size_t n_lookups = 4'000'000;
+
+    auto data = std::make_unique<std::array<std::pair<std::uint64_t, std::uint64_t>, Size>>();
+    for (std::size_t i = 0; i < Size; i++)
+    {
+        (*data)[i] = {mix(i), i};
+    }
+    auto map = std::make_unique<Map<std::uint64_t, std::uint64_t, Size>>(*data);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> dist(0, Size - 1);
+    std::vector<std::uint64_t> keys(n_lookups);
+    std::ranges::generate(keys, [&]
+                          { return (*data)[dist(gen)].first; });
+    std::vector<std::uint64_t> values(n_lookups);
+
+    auto time_lookups = [&](auto lookup)
+    {
+        auto start = std::chrono::steady_clock::now();
+        lookup();
+        auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count() / n_lookups;
+        return std::pair{ns, std::accumulate(values.cbegin(), values.cend(), std::uint64_t{0})};
+    };
+
+    auto [at_ns, at_sum] = time_lookups([&]
+                                        {
+                                            for (std::size_t i = 0; i < n_lookups; i++)
+                                            {
+                                                values[i] = map->at(keys[i]);
+                                            } });
+    std::ranges::fill(values, 0);
+    auto [batch_ns, batch_sum] = time_lookups([&]
+                                              { map->lookup_batch(keys, values); });
+
+    std::cout << std::format("Size: {:>7}, at: {:>6.2f} ns, lookup_batch: {:>6.2f} ns ({:.1f}x){}\n",
+                             Size, at_ns, batch_ns, at_ns / batch_ns, at_sum == batch_sum ? "" : " (mismatch)");
+}
+
+// Scattered integer keys, generated at compile time
+template <std::size_t Size>
+consteval std::array<std::pair<std::uint64_t, int>, Size> make_integer_pairs()
+{
+    std::array<std::pair<std::uint64_t, int>, Size> pairs;
+    for (std::size_t i = 0; i < Size; i++)
+    {
+        pairs[i] = {i * 7919 + 1, static_cast<int>(i)};
+    }
+    return pairs;
+}
+
 int main()
 {
-    static constexpr std::array<std::pair<std::string, int>, 3> data{{{"red", 1},
-                                                                      {"blue", 2},
-                                                                      {"green", 3}}};
+    static constexpr std::array<std::pair<std::string_view, int>, 3> data{{{"red", 1},
+                                                                           {"blue", 2},
+                                                                           {"green", 3}}};
+
+    // Built at compile time
+    // The template arguments can be deduced from data, but GCC then places the
+    // map in writable memory, and cannot fold lookups with constant keys
+    static_assert(std::is_same_v<decltype(Map(data)), Map<std::string_view, int, 3>>);
+    static constexpr Map<std::string_view, int, 3> map(data);
+
+    // Lookup with a constant key, evaluated at compile time
+    constexpr int green = map.at("green");
+    static_assert(green == 3);
 
-    Map<std::string, int, 3> map(data);
+    // Lookup with a string literal key, which is hashed at compile time
+    static_assert(map.at("blue"_key) == 2 && !map.contains("purple"_key));
 
+    std::string key{"purple"};
     try
     {
-        std::string key{"purple"};
         decltype(auto) value = map.at(key);
         std::cout << std::format("{}: {}\n", key, value);
     }
     catch (const std::range_error &e)
     {
-        std::cerr << e.what();
+        std::cerr << std::format("{}: {}", key, e.what());
+    }
+
+    // The same lookup, without an exception
+    std::cout << std::format("{}: {}\n", key, map.get_or(key, 0));
+    static_assert(map.contains("red") && !map.contains("purple"));
+
+    // Largest map that is built at compile time within the default limits
+    static constexpr auto large_data = make_integer_pairs<10000>();
+    static constexpr Map<std::uint64_t, int, 10000> large_map(large_data);
+    static_assert(large_map.at(7919 * 9999 + 1) == 9999 && !large_map.contains(2));
+
+    // Values without a default constructor are constructed in place
+    struct Rgb
+    {
+        constexpr Rgb(std::uint8_t r, std::uint8_t g, std::uint8_t b) : r(r), g(g), b(b) {}
+        std::uint8_t r, g, b;
+    };
+    static constexpr std::array<std::pair<std::string_view, Rgb>, 3> rgb_data{{{"red", {255, 0, 0}},
+                                                                               {"blue", {0, 0, 255}},
+                                                                               {"green", {0, 255, 0}}}};
+    static constexpr Map<std::string_view, Rgb, 3> rgb_map(rgb_data);
+    static_assert(rgb_map.at("blue").b == 255 && rgb_map.at("green").g == 255);
+
+    // Sorted map, which supports ordered queries
+    static constexpr Map<std::string_view, int, 3, EytzingerLayout> sorted_map(data);
+    static_assert(sorted_map.lower_bound("c")->first == "green");
+    sorted_map.for_each_in_range("a", "h", [](std::string_view key, int value)
+                                 { std::cout << std::format("{}: {}\n", key, value); });
+
+    // Small map with enum keys, scanned with SIMD instructions
+    enum class Color : std::uint8_t
+    {
+        red,
+        blue,
+        green
+    };
+    static constexpr std::array<std::pair<Color, std::string_view>, 3> names{{{Color::red, "red"},
+                                                                              {Color::blue, "blue"},
+                                                                              {Color::green, "green"}}};
+    static constexpr Map<Color, std::string_view, 3, SimdScanLayout> color_names(names);
+    static_assert(color_names.at(Color::blue) == "blue");
+    std::cout << std::format("{}\n", color_names.at(Color::green));
+
+    // Map whose keys are only known at runtime
+    FlatMap<std::string, int> flat_map;
+    for (const auto &[key, value] : data)
+    {
+        flat_map.insert(std::string(key), value);
+    }
+    flat_map.erase("red");
+    // Looked up by std::string_view (without constructing a std::string)
+    std::cout << std::format("blue: {}, red: {}\n", flat_map.at(std::string_view("blue")), flat_map.contains("red"));
+
+    // Immutable map built from a runtime table, saved to a file and mapped back
+    const auto path = std::filesystem::temp_directory_path() / "colors.bin";
+    FrozenMap<std::string_view, int>::build(data).save(path);
+    const auto frozen_map = FrozenMap<std::string_view, int>::load(path);
+    std::cout << std::format("blue: {}, purple: {}\n", frozen_map.at("blue"), frozen_map.get_or("purple", 0));
+    std::filesystem::remove(path);
+
+    // Corrupted blobs are rejected when they are loaded, rather than when
+    // they are queried, e.g. seeds that would send a lookup past the keys
+    {
+        std::vector<std::pair<std::uint64_t, int>> pairs{{1, 1}, {2, 2}, {3, 3}};
+        const auto frozen_ints = FrozenMap<std::uint64_t, int>::build(pairs, FrozenLayout::perfect_hash);
+        frozen_ints.save(path);
+        std::vector<std::byte> blob(std::filesystem::file_size(path));
+        std::ifstream(path, std::ios::binary).read(reinterpret_cast<char *>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        std::fill_n(blob.begin() + FrozenMap<std::uint64_t, int>::header_size, pairs.size() * sizeof(std::uint32_t), std::byte{0xff});
+        try
+        {
+            FrozenMap<std::uint64_t, int> corrupted(std::move(blob));
+        }
+        catch (const std::invalid_argument &e)
+        {
+            std::cout << std::format("{}\n", e.what());
+        }
+        std::filesystem::remove(path);
+    }
+
+    // Duplicate keys are rejected at once, whatever the layout
+    const std::vector<std::pair<std::string_view, int>> duplicates{{"red", 1}, {"red", 2}};
+    try
+    {
+        FrozenMap<std::string_view, int>::build(duplicates, FrozenLayout::perfect_hash);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::cout << std::format("{}\n", e.what());
+    }
+
+    // Compare the perfect hash with a linear scan, for increasing sizes
+    benchmark_lookup<4>();
+    benchmark_lookup<16>();
+    benchmark_lookup<64>();
+    benchmark_lookup<256>();
+    benchmark_lookup<1024>();
+    benchmark_lookup<10000>();
+
+    // Compare the SIMD key scan with the other layouts, for small sizes,
+    // with lookups spread evenly, and concentrated on the first keys
+    for (double hot_ratio : {0.0, 0.9})
+    {
+        benchmark_small_lookup<8>(hot_ratio);
+        benchmark_small_lookup<16>(hot_ratio);
+        benchmark_small_lookup<32>(hot_ratio);
+        benchmark_small_lookup<64>(hot_ratio);
+    }
+
+    // Compare the throwing and the non-throwing lookups, for increasing miss ratios
+    benchmark_misses<64>(0.0);
+    benchmark_misses<64>(0.1);
+    benchmark_misses<64>(0.5);
+    benchmark_misses<64>(0.9);
+
+    // Compare storing the keys separately from the values, for increasing value sizes
+    benchmark_value_size<8>();
+    benchmark_value_size<64>();
+    benchmark_value_size<256>();
+
+    // Compare the runtime hash maps with Map
+    benchmark_flat_map<1024>();
+    benchmark_flat_map<10000>();
+
+    // Compare batched lookups with lookups one by one, in a small and a large map
+    benchmark_lookup_batch<1024>();
+    benchmark_lookup_batch<131072>();
+
+    // Compare hashing a key once with hashing it for the lookup in each map
+    for (std::size_t key_length : {8, 64})
+    {
+        benchmark_hashed_keys<1024>(1, key_length);
+        benchmark_hashed_keys<1024>(4, key_length);
+    }
+
+    // Compare the layouts of FrozenMap, and building it with loading it
+    for (std::size_t n : {8, 1024})
+    {
+        for (std::size_t key_length : {8, 64, 256})
+        {
+            benchmark_frozen_layouts(n, key_length);
+        }
     }
+    benchmark_frozen_load(10'000);
+    benchmark_frozen_load(1'000'000);
 
     return 0;
-}
\ No newline at end of file
+}
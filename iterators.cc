@@ -21,85 +21,481 @@
 // is also a ForwardIterator, which in-turn is both a InputIterator and OutputIterator.
 
 #include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
 #include <numeric>
 #include <ranges>
+#include <utility>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cerrno>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stop_token>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include <format>
 #include <iostream>
 
 #define USE_CUSTOM_ITER 1
 #define USE_SPACESHIP 1
 
+// Custom iterator for DynamicArray
+// It is defined outside of DynamicArray, so that it can be reused by other
+// containers with contiguous storage (see MappedArray), and instantiated
+// for const elements
+template <typename T>
+class ArrayIterator // : public std::iterator<std::random_access_iterator_tag, T, ptrdiff_t, T *, T &>
+{
+public:
+    // An iterator should specify these 5 properties:
+    // 1) Category
+    // 2) Difference type
+    // 3) Value type
+    // 4) Pointer type
+    // 5) Reference type
+    // Tags are used when interacting with STL functions (such as those in <algorithm>),
+    // and help select the most appropriate implementation of such functions.
+    // Instead of defining them, the custom iterator class can inherit from std::iterator,
+    // but this practice is deprecated since C++17
+    // Since C++20, iterator_concept takes precedence over iterator_category for the
+    // iterator concepts (std::contiguous_iterator etc.). There is no (legacy)
+    // contiguous category, so iterator_category remains random access.
+    // The library algorithms may detect contiguous iterators, convert them to
+    // pointers (std::to_address) and use memmove/memset/memcmp.
+    using iterator_concept = std::contiguous_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_cv_t<T>;
+    using element_type = T;
+    using pointer = T *;
+    using reference = T &;
+
+    // Iterators should be constructible, copy-constructible, copy-assignable,
+    // swappable and destructuble.
+    // By only defining this constructor, the compiler will generate the rest
+    ArrayIterator(pointer ptr)
+        : ptr_(ptr)
+    {
+    }
+
+    // Default-construction is a requirement for ForwardIterator
+    ArrayIterator() = default;
+
+    // Conversion from iterator to const_iterator (but not the opposite)
+    template <typename U>
+        requires std::is_same_v<const U, T>
+    ArrayIterator(const ArrayIterator<U> &other)
+        : ptr_(other.operator->())
+    {
+    }
+
+    // Dereference operator
+    // Returns reference to the object the iterator points to
+    // The constness of the iterator does not affect the constness of the
+    // object, i.e. this is also the dereference operator of a const iterator
+    // Required by: InputIterator, OutputIterator
+    reference operator*() const
+    {
+        return *ptr_;
+    }
+
+    // Member access operator
+    // Returns the address of the object the iterator points to
+    // Required by: ContiguousIterator (via std::to_address)
+    pointer operator->() const
+    {
+        return ptr_;
+    }
+
+    // Subscript operator
+    // Returns a reference to the
+    // Required by: RandomAccessIterator
+    reference operator[](const difference_type &diff) const
+    {
+        return ptr_[diff];
+    }
+
+    // Pre-increment operator: ++iterator
+    // Increment and return
+    // Required by: InputIterator, OutputIterator
+    ArrayIterator &operator++()
+    {
+        ptr_++;
+        return *this;
+    }
+
+    // Post-increment operator: iterator++
+    // Return, then increment
+    // Required by: InputIterator, OutputIterator
+    ArrayIterator operator++(int)
+    {
+        ArrayIterator tmp(*this);
+        ++*this; // Pre-increment
+        return tmp;
+    }
+
+    // Pre-decrement operator: --iterator
+    // Decrement and return
+    // Required by: BiDirectionalIterator
+    ArrayIterator &operator--()
+    {
+        ptr_--;
+        return *this;
+    }
+
+    // Post-decrement operator: iterator--
+    // Return, then decrement
+    // Required by: BiDirectionalIterator
+    ArrayIterator operator--(int)
+    {
+        ArrayIterator tmp(*this);
+        --*this; // Pre-decrement
+        return tmp;
+    }
+
+    // it += diff
+    // Required by: RandomAccessIterator
+    ArrayIterator &operator+=(difference_type diff)
+    {
+        ptr_ += diff;
+        return *this;
+    }
+
+    // it -= diff
+    // Required by: RandomAccessIterator
+    ArrayIterator &operator-=(difference_type diff)
+    {
+        ptr_ -= diff;
+        return *this;
+    }
+
+    // Equality operator
+    // Required by: ForwardIterator
+    friend bool operator==(const ArrayIterator &lhs, const ArrayIterator &rhs)
+    {
+        return lhs.ptr_ == rhs.ptr_;
+    }
+
+    // Ineqquality operator
+    // Required by: ForwardIterator
+    // Note: Implicitly constructed from operator== since C++20
+    friend bool operator!=(const ArrayIterator &lhs, const ArrayIterator &rhs)
+    {
+        return lhs.ptr_ != rhs.ptr_;
+    }
+
+// RandomAccessIterator requires that all comparison operators are defined
+#if (USE_SPACESHIP == 1)
+    // Spaceship operator
+    // Required by: RandomAcessIterator
+    friend std::strong_ordering operator<=>(const ArrayIterator &lhs, const ArrayIterator &rhs)
+    {
+        return lhs.ptr_ <=> rhs.ptr_;
+    }
+#else
+    // Less-than operator
+    // Required by: RandomAccessIterator
+    friend bool operator<(const ArrayIterator &lhs, const ArrayIterator &rhs)
+    {
+        return lhs.ptr_ < rhs.ptr_;
+    }
+
+    // Less-than or equal to operator
+    // Required by: RandomAccessIterator
+    friend bool operator<=(const ArrayIterator &lhs, const ArrayIterator &rhs)
+    {
+        return lhs.ptr_ <= rhs.ptr_;
+    }
+
+    // Greater-than operator
+    // Required by: RandomAccessIterator
+    friend bool operator>(const ArrayIterator &lhs, const ArrayIterator &rhs)
+    {
+        return lhs.ptr_ > rhs.ptr_;
+    }
+
+    // Greater-than or equal to operator
+    // Required by: RandomAccessIterator
+    friend bool operator>=(const ArrayIterator &lhs, const ArrayIterator &rhs)
+    {
+        return lhs.ptr_ >= rhs.ptr_;
+    }
+#endif
+    // result (diff) = lhs (it) - rhs (it)
+    // Required by: RandomAccessIterator
+    friend difference_type operator-(const ArrayIterator &lhs, const ArrayIterator &rhs)
+    {
+        return static_cast<difference_type>(lhs.ptr_ - rhs.ptr_);
+    }
+
+    // result (it) =  it - diff
+    // Required by: RandomAccessIterator
+    friend ArrayIterator operator-(const ArrayIterator &it, const difference_type &diff)
+    {
+        return ArrayIterator(it.ptr_ - diff);
+    }
+
+    // result (it) = it + diff
+    // Required by: RandomAccessIterator
+    friend ArrayIterator operator+(const ArrayIterator &it, const difference_type &diff)
+    {
+        return ArrayIterator(it.ptr_ + diff);
+    }
+
+    // result (it) = diff + it
+    // Required by: RandomAccessIterator
+    friend ArrayIterator operator+(const difference_type &diff, const ArrayIterator &it)
+    {
+        return ArrayIterator(diff + it.ptr_);
+    }
+
+private:
+    pointer ptr_{nullptr};
+};
+
+// Tag used to select the DynamicArray constructor
+// that does not initialize the elements
+struct uninitialized_t
+{
+    explicit uninitialized_t() = default;
+};
+inline constexpr uninitialized_t uninitialized{};
+
+// Tag used to select the DynamicArray constructors
+// that initialize the elements in parallel
+struct parallel_init_t
+{
+    explicit parallel_init_t() = default;
+};
+inline constexpr parallel_init_t parallel_init{};
+
+// Defined along with the parallel algorithms (see below)
+template <typename T, typename F>
+void parallel_for(std::size_t n, F &&f);
+
 // The DynamicArray class is wrapper around
 // a heap-allocated array. It is, in essence,
 // similar to std::vector, with reduced functionality.
 // It will be a used as an example container, for which a
 // custom iterator must be created.
-template <typename T>
+// Storage is allocated uninitialized and elements are constructed
+// in-place, so that the array can hold more capacity than elements
+// and grow geometrically when appended to (amortized O(1) push_back).
+// The storage is obtained from an Allocator, which defaults to std::allocator
+// (i.e. operator new). Passing a std::pmr::polymorphic_allocator allows the
+// memory to be drawn from any std::pmr::memory_resource (see PmrDynamicArray).
+// The storage is aligned to Alignment bytes, and its size is padded to a
+// multiple of Alignment, i.e. capacity() may exceed the requested size.
+// With Alignment equal to the SIMD vector width, vectorized loops over the
+// array can use aligned loads, and process the tail with full vectors.
+// With Alignment equal to the cache line size, slices of the array that
+// are a multiple of Alignment bytes never share a cache line.
+// Up to InlineCapacity elements are stored inside the DynamicArray object
+// itself (small-buffer optimization), so short arrays never allocate.
+// The elements are moved to the heap, once the array outgrows the inline
+// storage. Note that, unlike the heap storage, the inline storage cannot
+// be stolen: moving an inline array moves its elements one by one, and
+// invalidates its iterators.
+template <typename T, typename Allocator = std::allocator<T>, std::size_t Alignment = alignof(T), std::size_t InlineCapacity = 0>
 class DynamicArray
 {
+    static_assert(std::has_single_bit(Alignment), "Alignment must be a power of 2");
+    static_assert(Alignment >= alignof(T), "Alignment must be at least alignof(T)");
+
+    // The storage is allocated as an array of blocks, each of which has
+    // the requested alignment and size, which the allocator is rebound to
+    struct alignas(Alignment) Block
+    {
+        std::byte bytes[Alignment];
+    };
+
+    // The inline storage is padded to whole blocks, like the heap storage
+    // When there is no inline storage, an empty struct is used instead,
+    // which occupies no space due to [[no_unique_address]]
+    static constexpr std::size_t n_inline_blocks = (InlineCapacity * sizeof(T) + Alignment - 1) / Alignment;
+    static constexpr std::size_t inline_capacity = n_inline_blocks * Alignment / sizeof(T);
+
+    struct InlineStorage
+    {
+        Block blocks[std::max(n_inline_blocks, std::size_t{1})];
+    };
+
+    struct NoInlineStorage
+    {
+    };
+
+    using inline_storage_type = std::conditional_t<(n_inline_blocks > 0), InlineStorage, NoInlineStorage>;
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using block_allocator = typename alloc_traits::template rebind_alloc<Block>;
+    using block_traits = std::allocator_traits<block_allocator>;
+
 public:
-    DynamicArray(std::size_t size)
-        : size_(size),
-          values_(new T[size]{})
+    using allocator_type = Allocator;
+
+    DynamicArray() = default;
+
+    explicit DynamicArray(const Allocator &alloc)
+        : allocator_(alloc)
+    {
+    }
+
+    // Each of the following constructors writes every element exactly once
+    // Elements are value-initialized, i.e. zeroed for trivial types
+    DynamicArray(std::size_t size, const Allocator &alloc = Allocator())
+        : DynamicArray(storage_only, size, alloc)
     {
+        std::uninitialized_value_construct_n(values_, size);
+        size_ = size;
     }
 
-    DynamicArray(std::size_t size, const T &value)
-        : DynamicArray(size)
+    // Elements are default-initialized, i.e. left uninitialized for trivial
+    // types, so no memory is written until the caller fills the array
+    DynamicArray(std::size_t size, uninitialized_t, const Allocator &alloc = Allocator())
+        : DynamicArray(storage_only, size, alloc)
     {
-        std::fill(values_, values_ + size_, value);
+        std::uninitialized_default_construct_n(values_, size);
+        size_ = size;
     }
 
-    DynamicArray(std::initializer_list<T> l)
-        : DynamicArray(l.size())
+    DynamicArray(std::size_t size, const T &value, const Allocator &alloc = Allocator())
+        : DynamicArray(storage_only, size, alloc)
     {
-        std::copy(l.begin(), l.end(), values_);
+        std::uninitialized_fill_n(values_, size, value);
+        size_ = size;
+    }
+
+    // Elements are initialized in parallel, by the threads of the ThreadPool
+    // The OS places each page of memory on the NUMA node of the thread that
+    // first writes to it (first-touch policy). Thus, if the array was instead
+    // initialized by a single thread, all of it would reside on one node, and
+    // threads on other nodes would access it at a fraction of the bandwidth.
+    // Here, each chunk of the array is first written by the same thread that
+    // the parallel algorithms assign it to, so it is local to that thread.
+    // Note that this assumes that the allocator returns untouched memory,
+    // which is the case for large allocations with operator new (mmap).
+    DynamicArray(std::size_t size, parallel_init_t, const Allocator &alloc = Allocator())
+        requires std::is_nothrow_default_constructible_v<T>
+        : DynamicArray(storage_only, size, alloc)
+    {
+        T *values = values_;
+        parallel_for<T>(size, [values](std::size_t first, std::size_t last)
+                        { std::uninitialized_value_construct(values + first, values + last); });
+        size_ = size;
+    }
+
+    DynamicArray(std::size_t size, const T &value, parallel_init_t, const Allocator &alloc = Allocator())
+        requires std::is_nothrow_copy_constructible_v<T>
+        : DynamicArray(storage_only, size, alloc)
+    {
+        T *values = values_;
+        parallel_for<T>(size, [values, &value](std::size_t first, std::size_t last)
+                        { std::uninitialized_fill(values + first, values + last, value); });
+        size_ = size;
+    }
+
+    DynamicArray(std::initializer_list<T> l, const Allocator &alloc = Allocator())
+        : DynamicArray(storage_only, l.size(), alloc)
+    {
+        std::uninitialized_copy(l.begin(), l.end(), values_);
+        size_ = l.size();
     }
 
     ~DynamicArray()
     {
-        if (values_ != nullptr)
-        {
-            delete[] values_;
-        }
+        release();
     }
 
     DynamicArray(const DynamicArray &other)
-        : DynamicArray(other.size_)
+        : DynamicArray(storage_only, other.size_, alloc_traits::select_on_container_copy_construction(other.allocator_))
     {
-        std::copy(other.values_, other.values_ + other.size_, values_);
+        std::uninitialized_copy_n(other.values_, other.size_, values_);
+        size_ = other.size_;
     }
 
-    DynamicArray(DynamicArray &&other)
-        : DynamicArray(other.size_)
+    // Moving steals the buffer of other, which is left empty
+    // No allocation and no element is touched, so the cost is O(1)
+    // The noexcept specification allows containers such as std::vector
+    // to move (instead of copy) DynamicArrays when they reallocate
+    DynamicArray(DynamicArray &&other) noexcept(InlineCapacity == 0 || std::is_nothrow_move_constructible_v<T>)
+        : allocator_(std::move(other.allocator_))
     {
-        std::copy(other.values_, other.values_ + other.size_, values_);
-        other.size_ = 0;
-        delete[] other.values_;
-        other.values_ = nullptr;
+        steal(other);
     }
 
     DynamicArray &operator=(const DynamicArray &other)
     {
-        size_ = other.size_;
-        delete[] values_;
-        values_ = new T[size_];
-        std::copy(other.values_, other.values_ + other.size_, values_);
+        if (this != &other)
+        {
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+            {
+                if (allocator_ != other.allocator_)
+                {
+                    release();
+                }
+                allocator_ = other.allocator_;
+            }
+            clear();
+            reserve(other.size_);
+            std::uninitialized_copy_n(other.values_, other.size_, values_);
+            size_ = other.size_;
+        }
         return *this;
     }
 
-    DynamicArray &operator=(DynamicArray &&other)
+    // The buffer of other can only be stolen if it can be freed by our
+    // allocator. Otherwise (e.g. two polymorphic allocators with different
+    // memory resources) the elements have to be moved one by one.
+    DynamicArray &operator=(DynamicArray &&other) noexcept((alloc_traits::propagate_on_container_move_assignment::value ||
+                                                            alloc_traits::is_always_equal::value) &&
+                                                           (InlineCapacity == 0 || std::is_nothrow_move_constructible_v<T>))
     {
-        size_ = other.size_;
-        delete values_;
-        values_ = new T[size_];
-        std::copy(other.values_, other.values_ + other.size_, values_);
-        other.size_ = 0;
-        delete other.values_;
+        if (this != &other)
+        {
+            if constexpr (!alloc_traits::propagate_on_container_move_assignment::value &&
+                          !alloc_traits::is_always_equal::value)
+            {
+                if (allocator_ != other.allocator_)
+                {
+                    clear();
+                    reserve(other.size_);
+                    std::uninitialized_move_n(other.values_, other.size_, values_);
+                    size_ = other.size_;
+                    other.clear();
+                    return *this;
+                }
+            }
+            release();
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                allocator_ = std::move(other.allocator_);
+            }
+            steal(other);
+        }
         return *this;
     }
 
-    T &operator[](int idx)
+    T &operator[](std::size_t idx)
     {
         if (idx >= size_)
         {
@@ -108,242 +504,878 @@ public:
         return values_[idx];
     }
 
-#if (USE_CUSTOM_ITER == 1)
-    // Custom iterator for DynamicArray
-    class iterator // : public std::iterator<std::random_access_iterator_tag, T, ptrdiff_t, T *, T &>
+    std::size_t size() const
     {
-    public:
-        // An iterator should specify these 5 properties:
-        // 1) Category
-        // 2) Difference type
-        // 3) Value type
-        // 4) Pointer type
-        // 5) Reference type
-        // Tags are used when interacting with STL functions (such as those in <algorithm>),
-        // and help select the most appropriate implementation of such functions.
-        // Instead of defining them, the custom iterator class can inherit from std::iterator,
-        // but this practice is deprecated since C++17
-        using iterator_category = std::random_access_iterator_tag;
-        using difference_type = std::ptrdiff_t;
-        using value_type = T;
-        using pointer = value_type *;
-        using reference = value_type &;
+        return size_;
+    }
 
-        // Iterators should be constructible, copy-constructible, copy-assignable,
-        // swappable and destructuble.
-        // By only defining this constructor, the compiler will generate the rest
-        iterator(pointer ptr)
-            : ptr_(ptr)
-        {
-        }
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
 
-        // Default-construction is a requirement for ForwardIterator
-        iterator() = default;
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return allocator_;
+    }
+
+    static constexpr std::size_t alignment()
+    {
+        return Alignment;
+    }
 
-        // Dereference operator
-        // Returns reference to the object the iterator points to
-        // Required by: OutputIterator
-        reference operator*()
+    // Pointer to the underlying storage
+    // The compiler is told that it is aligned to Alignment bytes
+    // (std::assume_aligned), so that it can emit aligned vector loads
+    T *data()
+    {
+        return std::assume_aligned<Alignment>(values_);
+    }
+
+    const T *data() const
+    {
+        return std::assume_aligned<Alignment>(values_);
+    }
+
+    // Make sure that at least new_capacity elements
+    // fit without reallocation. Never shrinks the storage.
+    void reserve(std::size_t new_capacity)
+    {
+        if (new_capacity > capacity_)
         {
-            return *ptr_;
+            reallocate(new_capacity);
         }
+    }
 
-        // Const dereference operator
-        // Returns const reference to the object the iterator points to
-        // Required by: InputIterator
-        const reference operator*() const
+    // Change the number of elements. New elements are
+    // value-initialized, or copies of value in the second overload.
+    void resize(std::size_t new_size)
+    {
+        if (new_size > size_)
         {
-            return *ptr_;
+            reserve(grown_capacity(new_size));
+            std::uninitialized_value_construct_n(values_ + size_, new_size - size_);
         }
-
-        // Subscript operator
-        // Returns a reference to the
-        // Required by: RandomAccessIterator
-        reference operator[](const difference_type &diff) const
+        else
         {
-            return ptr_[diff];
+            std::destroy_n(values_ + new_size, size_ - new_size);
         }
+        size_ = new_size;
+    }
 
-        // Pre-increment operator: ++iterator
-        // Increment and return
-        // Required by: InputIterator, OutputIterator
-        iterator &operator++()
+    void resize(std::size_t new_size, const T &value)
+    {
+        if (new_size > capacity_)
         {
-            ptr_++;
-            return *this;
+            // The new elements are constructed before the existing ones are
+            // relocated, since value may refer to an element of this array
+            const std::size_t new_capacity = grown_capacity(new_size);
+            T *new_values = allocate(new_capacity);
+            try
+            {
+                std::uninitialized_fill_n(new_values + size_, new_size - size_, value);
+            }
+            catch (...)
+            {
+                deallocate(new_values, new_capacity);
+                throw;
+            }
+            relocate(new_values, new_capacity, new_size - size_);
         }
-
-        // Post-increment operator: iterator++
-        // Return, then increment
-        // Required by: InputIterator, OutputIterator
-        iterator operator++(int)
+        else if (new_size > size_)
+        {
+            std::uninitialized_fill_n(values_ + size_, new_size - size_, value);
+        }
+        else
         {
-            iterator tmp(*this);
-            ++*this; // Pre-increment
-            return tmp;
+            std::destroy_n(values_ + new_size, size_ - new_size);
         }
+        size_ = new_size;
+    }
 
-        // Pre-decrement operator: --iterator
-        // Decrement and return
-        // Required by: BiDirectionalIterator
-        iterator &operator--()
+    // Release any unused capacity
+    void shrink_to_fit()
+    {
+        if (capacity_ > storage_capacity(size_))
         {
-            ptr_--;
-            return *this;
+            reallocate(size_);
         }
+    }
+
+    // Destroy all elements, but keep the capacity
+    void clear()
+    {
+        std::destroy_n(values_, size_);
+        size_ = 0;
+    }
+
+    void push_back(const T &value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T &&value)
+    {
+        emplace_back(std::move(value));
+    }
 
-        // Post-decrement operator: iterator--
-        // Return, then decrement
-        // Required by: BiDirectionalIterator
-        iterator operator--(int)
+    // Construct a new element in-place at the end of the array.
+    // When the array is full, the capacity is multiplied by growth_factor,
+    // so that N appends cost O(N) element moves in total.
+    template <typename... Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (size_ == capacity_)
+        {
+            // The new element is constructed before the existing ones are
+            // relocated, since args may refer to an element of this array
+            const std::size_t new_capacity = grown_capacity(size_ + 1);
+            T *new_values = allocate(new_capacity);
+            try
+            {
+                std::construct_at(new_values + size_, std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                deallocate(new_values, new_capacity);
+                throw;
+            }
+            relocate(new_values, new_capacity, 1);
+        }
+        else
         {
-            iterator tmp(*this);
-            --*this; // Pre-decrement
-            return tmp;
+            std::construct_at(values_ + size_, std::forward<Args>(args)...);
         }
+        return values_[size_++];
+    }
+
+#if (USE_CUSTOM_ITER == 1)
+    using iterator = ArrayIterator<T>;
+    using const_iterator = ArrayIterator<const T>;
+#else
+    // Alternative approach
+    // If a class wraps an STL container (or C-style array),
+    // it is not necessary to create a custom iterator from
+    // scratch. It is adequate to provide the begin() and end()
+    // functions.
+    using iterator = T *;
+    using const_iterator = T const *;
+#endif
+
+    iterator begin()
+    {
+        return iterator(data());
+    }
 
-        // it += diff
-        // Required by: RandomAccessIterator
-        iterator &operator+=(difference_type diff)
+    iterator end()
+    {
+        return iterator(data() + size_);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(data());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(data() + size_);
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+private:
+    static constexpr std::size_t growth_factor = 2;
+
+    // Allocate storage for capacity elements, without constructing any
+    // The public constructors delegate to this one, so that the storage is
+    // freed by the destructor if the construction of an element throws
+    struct storage_only_t
+    {
+    };
+    static constexpr storage_only_t storage_only{};
+
+    DynamicArray(storage_only_t, std::size_t capacity, const Allocator &alloc)
+        : allocator_(alloc),
+          capacity_(storage_capacity(capacity)),
+          values_(allocate(capacity_))
+    {
+    }
+
+    // Capacity to use when at least min_capacity elements must fit
+    std::size_t grown_capacity(std::size_t min_capacity) const
+    {
+        return storage_capacity(std::max(min_capacity, growth_factor * capacity_));
+    }
+
+    // Number of blocks required to store n elements
+    static std::size_t n_blocks(std::size_t n)
+    {
+        return (n * sizeof(T) + Alignment - 1) / Alignment;
+    }
+
+    // Number of elements that fit in the blocks required to store n elements
+    static std::size_t padded_capacity(std::size_t n)
+    {
+        return n_blocks(n) * Alignment / sizeof(T);
+    }
+
+    // Capacity of the storage that allocate(n) returns
+    static std::size_t storage_capacity(std::size_t n)
+    {
+        return n <= inline_capacity ? inline_capacity : padded_capacity(n);
+    }
+
+    T *inline_values()
+    {
+        if constexpr (n_inline_blocks > 0)
         {
-            ptr_ += diff;
-            return *this;
+            return reinterpret_cast<T *>(inline_storage_.blocks);
         }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    bool is_inline() const
+    {
+        return n_inline_blocks > 0 && static_cast<const void *>(values_) == static_cast<const void *>(&inline_storage_);
+    }
 
-        // it -= diff
-        // Required by: RandomAccessIterator
-        iterator &operator-=(difference_type diff)
+    // The inline storage is used whenever n elements fit in it
+    T *allocate(std::size_t n)
+    {
+        if (n <= inline_capacity)
         {
-            ptr_ -= diff;
-            return *this;
+            return inline_values();
         }
+        block_allocator blocks(allocator_);
+        return reinterpret_cast<T *>(block_traits::allocate(blocks, n_blocks(n)));
+    }
 
-        // Equality operator
-        // Required by: ForwardIterator
-        friend bool operator==(const iterator &lhs, const iterator &rhs)
+    void deallocate(T *values, std::size_t n)
+    {
+        if (values != nullptr && values != inline_values())
         {
-            return lhs.ptr_ == rhs.ptr_;
+            block_allocator blocks(allocator_);
+            block_traits::deallocate(blocks, reinterpret_cast<Block *>(values), n_blocks(n));
         }
+    }
 
-        // Ineqquality operator
-        // Required by: ForwardIterator
-        // Note: Implicitly constructed from operator== since C++20
-        friend bool operator!=(const iterator &lhs, const iterator &rhs)
+    // Move the elements into a new buffer of size new_capacity.
+    // Elements are copied instead, if moving them might throw,
+    // so that the array is left intact on failure.
+    // The n_constructed elements past size_ in new_values are
+    // already constructed, and are destroyed on failure.
+    void relocate(T *new_values, std::size_t new_capacity, std::size_t n_constructed = 0)
+    {
+        try
+        {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+            {
+                std::uninitialized_move_n(values_, size_, new_values);
+            }
+            else
+            {
+                std::uninitialized_copy_n(values_, size_, new_values);
+            }
+        }
+        catch (...)
         {
-            return lhs.ptr_ != rhs.ptr_;
+            std::destroy_n(new_values + size_, n_constructed);
+            deallocate(new_values, new_capacity);
+            throw;
         }
+        std::destroy_n(values_, size_);
+        deallocate(values_, capacity_);
+        values_ = new_values;
+        capacity_ = new_capacity;
+    }
 
-// RandomAccessIterator requires that all comparison operators are defined
-#if (USE_SPACESHIP == 1)
-        // Spaceship operator
-        // Required by: RandomAcessIterator
-        friend bool operator<=>(const iterator &lhs, const iterator &rhs)
+    void reallocate(std::size_t new_capacity)
+    {
+        new_capacity = storage_capacity(new_capacity);
+        relocate(allocate(new_capacity), new_capacity);
+    }
+
+    // Destroy all elements and free the storage
+    // The array falls back to its inline storage, if any
+    void release()
+    {
+        std::destroy_n(values_, size_);
+        deallocate(values_, capacity_);
+        size_ = 0;
+        capacity_ = inline_capacity;
+        values_ = inline_values();
+    }
+
+    // Take over the elements of other, which is left empty
+    // Assumes that this array holds no elements and no heap storage
+    void steal(DynamicArray &other)
+    {
+        if (other.is_inline())
         {
-            return lhs.ptr_ <=> rhs.ptr_;
+            std::uninitialized_move_n(other.values_, other.size_, values_);
+            size_ = other.size_;
+            other.clear();
         }
-#else
-        // Less-than operator
-        // Required by: RandomAccessIterator
-        friend bool operator<(const iterator &lhs, const iterator &rhs)
+        else
         {
-            return lhs.ptr_ < rhs.ptr_;
+            size_ = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, inline_capacity);
+            values_ = std::exchange(other.values_, other.inline_values());
         }
+    }
+
+    [[no_unique_address]] Allocator allocator_{};
+    [[no_unique_address]] inline_storage_type inline_storage_;
+    std::size_t size_{0};
+    std::size_t capacity_{inline_capacity};
+    T *values_{inline_values()};
+};
+
+// DynamicArray that draws its memory from a std::pmr::memory_resource,
+// chosen at runtime. The standard library already provides the resources
+// for the most common strategies:
+// 1) std::pmr::monotonic_buffer_resource: arena, for short-lived arrays.
+//    Allocation bumps a pointer, deallocation is a no-op and all memory
+//    is released at once when the arena is destroyed.
+// 2) std::pmr::(un)synchronized_pool_resource: pools of fixed-size blocks,
+//    for long-lived arrays that are frequently created and destroyed.
+//    Use one unsynchronized pool per thread to avoid contention.
+// 3) HugePageResource (below): for large arrays.
+template <typename T>
+using PmrDynamicArray = DynamicArray<T, std::pmr::polymorphic_allocator<T>>;
+
+// DynamicArray whose storage is aligned to (and padded to a multiple of)
+// a cache line, which is also the width of an AVX-512 vector
+constexpr std::size_t cache_line_size = 64;
 
-        // Less-than or equal to operator
-        // Required by: RandomAccessIterator
-        friend bool operator<=(const iterator &lhs, const iterator &rhs)
+template <typename T, std::size_t Alignment = cache_line_size>
+using AlignedDynamicArray = DynamicArray<T, std::allocator<T>, Alignment>;
+
+// DynamicArray that stores up to N elements inline (cf. small_vector)
+template <typename T, std::size_t N = 16>
+using SmallDynamicArray = DynamicArray<T, std::allocator<T>, alignof(T), N>;
+
+// Memory resource that backs allocations with 2 MiB (huge) pages.
+// Each allocation is aligned to and rounded up to a whole number of
+// huge pages, and the kernel is asked to back it with transparent huge
+// pages. This reduces the TLB misses (and page faults) when traversing
+// large arrays, but wastes memory for small ones.
+class HugePageResource : public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        const std::size_t size = (std::max(bytes, std::size_t{1}) + huge_page_size - 1) / huge_page_size * huge_page_size;
+        void *ptr = std::aligned_alloc(std::max(alignment, huge_page_size), size);
+        if (ptr == nullptr)
         {
-            return lhs.ptr_ <= rhs.ptr_;
+            throw std::bad_alloc();
         }
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+        return ptr;
+    }
+
+    void do_deallocate(void *ptr, std::size_t, std::size_t) override
+    {
+        std::free(ptr);
+    }
+
+    // Memory allocated by any HugePageResource can be freed by any other
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return dynamic_cast<const HugePageResource *>(&other) != nullptr;
+    }
+};
+
+// The MappedArray class maps a binary file of T's into memory (mmap),
+// and exposes it as an array, without reading the file. Construction
+// costs a system call, regardless of the file size, and pages are only
+// read from disk (or the page cache) once they are accessed. Thus, files
+// larger than RAM can be processed, e.g. with the std::ranges algorithms.
+// There are two modes, selected by the constness of T:
+// 1) MappedArray<const T>: read-only mapping. Writing through it is a
+//    compile-time error.
+// 2) MappedArray<T>: copy-on-write (private) mapping. Elements can be
+//    modified, but each modified page is copied on its first write,
+//    and the changes are never written back to the file.
+template <typename T>
+class MappedArray
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be mapped from a file");
+
+public:
+    // Hints on how the elements will be accessed, which let the kernel
+    // choose the read-ahead policy (see madvise)
+    enum class Advice
+    {
+        normal = MADV_NORMAL,
+        sequential = MADV_SEQUENTIAL, // Aggressive read-ahead, pages can be freed soon after access
+        random = MADV_RANDOM,         // No read-ahead
+        willneed = MADV_WILLNEED,     // Start reading the pages in the background
+        dontneed = MADV_DONTNEED      // The pages will not be accessed soon (read-only mappings only)
+    };
 
-        // Greater-than operator
-        // Required by: RandomAccessIterator
-        friend bool operator>(const iterator &lhs, const iterator &rhs)
+    explicit MappedArray(const std::filesystem::path &path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1)
         {
-            return lhs.ptr_ > rhs.ptr_;
+            throw std::system_error(errno, std::generic_category(), std::format("Could not open {}", path.string()));
         }
 
-        // Greater-than or equal to operator
-        // Required by: RandomAccessIterator
-        friend bool operator>=(const iterator &lhs, const iterator &rhs)
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) == -1)
         {
-            return lhs.ptr_ >= rhs.ptr_;
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), std::format("Could not stat {}", path.string()));
         }
-#endif
-        // result (diff) = lhs (it) - rhs (it)
-        // Required by: RandomAccessIterator
-        friend difference_type operator-(const iterator &lhs, const iterator &rhs)
+
+        // Trailing bytes that do not form a whole element are ignored
+        size_ = static_cast<std::size_t>(file_stat.st_size) / sizeof(T);
+        if (size_ > 0)
         {
-            return static_cast<difference_type>(lhs.ptr_ - rhs.ptr_);
+            constexpr int protection = std::is_const_v<T> ? PROT_READ : PROT_READ | PROT_WRITE;
+            constexpr int flags = std::is_const_v<T> ? MAP_SHARED : MAP_PRIVATE;
+            void *addr = ::mmap(nullptr, size_ * sizeof(T), protection, flags, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), std::format("Could not map {}", path.string()));
+            }
+            values_ = static_cast<T *>(addr);
         }
 
-        // result (it) =  it - diff
-        // Required by: RandomAccessIterator
-        friend iterator operator-(const iterator &it, const difference_type &diff)
+        // The mapping remains valid after the file is closed
+        ::close(fd);
+    }
+
+    ~MappedArray()
+    {
+        if (values_ != nullptr)
         {
-            return iterator(it.ptr_ - diff);
+            ::munmap(const_cast<std::remove_const_t<T> *>(values_), size_ * sizeof(T));
         }
+    }
+
+    MappedArray(const MappedArray &) = delete;
+    MappedArray &operator=(const MappedArray &) = delete;
+
+    MappedArray(MappedArray &&other) noexcept
+        : size_(std::exchange(other.size_, 0)),
+          values_(std::exchange(other.values_, nullptr))
+    {
+    }
+
+    MappedArray &operator=(MappedArray &&other) noexcept
+    {
+        std::swap(size_, other.size_);
+        std::swap(values_, other.values_);
+        return *this;
+    }
 
-        // result (it) = diff - it
-        // Required by: RandomAccessIterator
-        friend iterator operator-(const difference_type &diff, const iterator &it)
+    // Advise the kernel on the access pattern of count elements, starting at first
+    // The range is extended to whole pages, as required by madvise
+    // Advice::dontneed drops the pages, and on a copy-on-write mapping the
+    // private copies of the modified ones as well, so that later reads would
+    // see the contents of the file again. Hence it throws for a non-const T
+    void advise(Advice advice, std::size_t first = 0, std::size_t count = std::size_t(-1))
+    {
+        if (!std::is_const_v<T> && advice == Advice::dontneed)
+        {
+            throw std::invalid_argument("Advice::dontneed would discard the changes to a copy-on-write mapping");
+        }
+        if (values_ == nullptr || first >= size_)
         {
-            return iterator(diff - it.ptr_);
+            return;
         }
+        count = std::min(count, size_ - first);
 
-        // result (it) = it + diff
-        // Required by: RandomAccessIterator
-        friend iterator operator+(const iterator &it, const difference_type &diff)
+        const auto page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        const auto begin = reinterpret_cast<std::uintptr_t>(values_ + first) / page_size * page_size;
+        const auto end = reinterpret_cast<std::uintptr_t>(values_ + first + count);
+        if (::madvise(reinterpret_cast<void *>(begin), end - begin, static_cast<int>(advice)) == -1)
         {
-            return iterator(it.ptr_ + diff);
+            throw std::system_error(errno, std::generic_category(), "madvise failed");
         }
+    }
 
-        // result (it) = diff + it
-        // Required by: RandomAccessIterator
-        friend iterator operator+(const difference_type &diff, const iterator &it)
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    T *data() const
+    {
+        return values_;
+    }
+
+    T &operator[](std::size_t idx) const
+    {
+        if (idx >= size_)
         {
-            return iterator(diff + it.ptr_);
+            throw std::range_error(std::format("Invalid index {} for MappedArray of size {}\n", idx, size_));
         }
+        return values_[idx];
+    }
 
-    private:
-        pointer ptr_{nullptr};
-    };
-    using const_iterator = const iterator;
+#if (USE_CUSTOM_ITER == 1)
+    using iterator = ArrayIterator<T>;
 #else
-    // Alternative approach
-    // If a class wraps an STL container (or C-style array),
-    // it is not necessary to create a custom iterator from
-    // scratch. It is adequate to provide the begin() and end()
-    // functions.
     using iterator = T *;
-    using const_iterator = T const *;
 #endif
 
-    iterator begin()
+    iterator begin() const
     {
         return iterator(values_);
     }
 
-    iterator end()
+    iterator end() const
     {
         return iterator(values_ + size_);
     }
 
-    const_iterator cbegin() const
+private:
+    std::size_t size_{0};
+    T *values_{nullptr};
+};
+
+// Pool of threads, which run the same task in parallel
+// Thread i of the pool always calls the task with index i, so that
+// tasks which partition their work by index (see parallel_for) hand
+// the same part of the work to the same thread on every call.
+// The threads are created once, as creating a thread per task would
+// cost more than the parallel algorithms save for medium-sized arrays.
+// On Linux, thread i is also pinned to the i-th CPU the process may run on,
+// so that the same part of the work is always processed on the same CPU,
+// and thus on the same NUMA node (see DynamicArray(size, parallel_init)).
+// A task may itself call run (e.g. through a parallel algorithm). Since the
+// threads of the pool are busy with the outer task, the inner one is then
+// run serially, by the calling thread. If a task throws, the first exception
+// is rethrown by run, once all the threads have finished.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(std::size_t n_threads = std::max(1u, std::thread::hardware_concurrency()))
     {
-        return const_iterator(values_);
+        const auto cpus = allowed_cpus();
+        for (std::size_t i = 0; i < n_threads; i++)
+        {
+            workers_.emplace_back([this, i](std::stop_token stop)
+                                  { work(stop, i); });
+            if (!cpus.empty())
+            {
+                pin(workers_.back(), cpus[i % cpus.size()]);
+            }
+        }
     }
 
-    const_iterator cend() const
+    ~ThreadPool()
+    {
+        for (auto &worker : workers_)
+        {
+            worker.request_stop();
+        }
+        start_.notify_all();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Pool shared by the parallel algorithms
+    static ThreadPool &instance()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    std::size_t size() const
+    {
+        return workers_.size();
+    }
+
+    // Call task(i) on thread i, for all threads of the pool,
+    // and wait until all calls return
+    void run(const std::function<void(std::size_t)> &task)
     {
-        return const_iterator(values_ + size_);
+        if (inside_pool_)
+        {
+            // Nested call: waiting for the pool would deadlock
+            for (std::size_t i = 0; i < workers_.size(); i++)
+            {
+                task(i);
+            }
+            return;
+        }
+
+        std::lock_guard run_lock(run_mutex_);
+        std::unique_lock lock(mutex_);
+        task_ = &task;
+        n_pending_ = workers_.size();
+        generation_++;
+        start_.notify_all();
+        done_.wait(lock, [this]
+                   { return n_pending_ == 0; });
+        if (exception_)
+        {
+            std::rethrow_exception(std::exchange(exception_, nullptr));
+        }
     }
 
 private:
-    std::size_t size_{0};
-    T *values_{nullptr};
+    void work(std::stop_token stop, std::size_t idx)
+    {
+        inside_pool_ = true;
+        std::size_t generation = 0;
+        while (true)
+        {
+            const std::function<void(std::size_t)> *task = nullptr;
+            {
+                std::unique_lock lock(mutex_);
+                if (!start_.wait(lock, stop, [&]
+                                 { return generation_ != generation; }))
+                {
+                    return; // Stop requested
+                }
+                generation = generation_;
+                task = task_;
+            }
+
+            std::exception_ptr exception;
+            try
+            {
+                (*task)(idx);
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            std::lock_guard lock(mutex_);
+            if (exception && !exception_)
+            {
+                exception_ = exception;
+            }
+            if (--n_pending_ == 0)
+            {
+                done_.notify_one();
+            }
+        }
+    }
+
+    // The CPUs in the affinity mask of the process
+    static std::vector<int> allowed_cpus()
+    {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+        return cpus;
+    }
+
+    // Pinning is only an optimization, so failures are ignored
+    static void pin([[maybe_unused]] std::jthread &thread, [[maybe_unused]] int cpu)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+    }
+
+    std::mutex run_mutex_; // Serializes calls to run
+    std::mutex mutex_;     // Protects the members below
+    std::condition_variable_any start_;
+    std::condition_variable done_;
+    const std::function<void(std::size_t)> *task_{nullptr};
+    std::size_t generation_{0};
+    std::size_t n_pending_{0};
+    std::exception_ptr exception_; // First exception thrown by the task
+    std::vector<std::jthread> workers_; // Destroyed (joined) first
+
+    // Whether the current thread is a thread of a pool
+    static inline thread_local bool inside_pool_{false};
 };
 
+// Parallel algorithms
+// The following functions are parallel counterparts of the <algorithm> and
+// <numeric> functions, for contiguous ranges (e.g. DynamicArray). The range
+// is split into one contiguous chunk per thread of the ThreadPool, and each
+// chunk is processed by a serial loop over raw pointers, which the compiler
+// vectorizes (SIMD). Ranges with fewer than parallel_threshold elements are
+// processed by the calling thread alone, since for them the cost of waking
+// up the pool exceeds the gain.
+constexpr std::size_t parallel_threshold = 32 * 1024;
+
+// Call f(chunk, first, last) for each chunk [first, last) of [0, n), in parallel
+// The chunks are multiples of the cache line, so that no two threads write
+// to the same cache line (false sharing). Chunk i is processed by thread i.
+// Returns the number of (non-empty) chunks, which is at most the pool size.
+template <typename T, typename F>
+std::size_t parallel_for_chunks(std::size_t n, F &&f)
+{
+    ThreadPool &pool = ThreadPool::instance();
+    if (n == 0)
+    {
+        return 0;
+    }
+    if (n < parallel_threshold || pool.size() == 1)
+    {
+        f(std::size_t{0}, std::size_t{0}, n);
+        return 1;
+    }
+
+    constexpr std::size_t line = std::max(cache_line_size / sizeof(T), std::size_t{1});
+    const std::size_t chunk = ((n + pool.size() - 1) / pool.size() + line - 1) / line * line;
+    const std::size_t n_chunks = (n + chunk - 1) / chunk;
+    pool.run([&](std::size_t i)
+             {
+                if (i < n_chunks)
+                {
+                    f(i, i * chunk, std::min((i + 1) * chunk, n));
+                } });
+    return n_chunks;
+}
+
+// Same as parallel_for_chunks, for functions that do not need the chunk index
+template <typename T, typename F>
+void parallel_for(std::size_t n, F &&f)
+{
+    parallel_for_chunks<T>(n, [&f](std::size_t, std::size_t first, std::size_t last)
+                           { f(first, last); });
+}
+
+template <std::ranges::contiguous_range R, typename T>
+void parallel_fill(R &&r, const T &value)
+{
+    auto *ptr = std::ranges::data(r);
+    parallel_for<std::ranges::range_value_t<R>>(std::ranges::size(r), [ptr, &value](std::size_t first, std::size_t last)
+                                                { std::fill(ptr + first, ptr + last, value); });
+}
+
+// r[i] = value + i
+template <std::ranges::contiguous_range R, typename T>
+void parallel_iota(R &&r, T value)
+{
+    using value_type = std::ranges::range_value_t<R>;
+    auto *ptr = std::ranges::data(r);
+    parallel_for<value_type>(std::ranges::size(r), [ptr, value](std::size_t first, std::size_t last)
+                             {
+                                for (std::size_t i = first; i < last; i++)
+                                {
+                                    ptr[i] = static_cast<value_type>(value + static_cast<T>(i));
+                                } });
+}
+
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range O, typename F>
+void parallel_transform(R &&r, O &&out, F op)
+{
+    const auto *in_ptr = std::ranges::data(r);
+    auto *out_ptr = std::ranges::data(out);
+    parallel_for<std::ranges::range_value_t<O>>(std::ranges::size(r), [in_ptr, out_ptr, &op](std::size_t first, std::size_t last)
+                                                { std::transform(in_ptr + first, in_ptr + last, out_ptr + first, op); });
+}
+
+// The order in which the elements are combined is unspecified,
+// i.e. op must be associative and commutative (cf. std::reduce)
+template <std::ranges::contiguous_range R, typename T, typename F = std::plus<>>
+T parallel_reduce(R &&r, T init, F op = {})
+{
+    const auto *ptr = std::ranges::data(r);
+    std::vector<T> partial(ThreadPool::instance().size()); // One partial result per chunk
+    const std::size_t n_chunks = parallel_for_chunks<std::ranges::range_value_t<R>>(
+        std::ranges::size(r), [ptr, &partial, &op](std::size_t chunk, std::size_t first, std::size_t last)
+        { partial[chunk] = std::reduce(ptr + first + 1, ptr + last, T(ptr[first]), op); });
+    return std::reduce(partial.begin(), partial.begin() + n_chunks, init, op);
+}
+
+// out[i] = r[0] op r[1] op ... op r[i]
+// Each chunk is reduced in parallel, the partial results are scanned,
+// and finally each chunk is scanned, starting from the result of the
+// preceding chunks. Thus, r is read twice, but in parallel.
+template <std::ranges::contiguous_range R, std::ranges::contiguous_range O, typename F = std::plus<>>
+void parallel_inclusive_scan(R &&r, O &&out, F op = {})
+{
+    using value_type = std::ranges::range_value_t<O>;
+    const auto *in_ptr = std::ranges::data(r);
+    auto *out_ptr = std::ranges::data(out);
+    const std::size_t n = std::ranges::size(r);
+
+    if (n < parallel_threshold || ThreadPool::instance().size() == 1)
+    {
+        std::inclusive_scan(in_ptr, in_ptr + n, out_ptr, op);
+        return;
+    }
+
+    std::vector<value_type> partial(ThreadPool::instance().size());
+    const std::size_t n_chunks = parallel_for_chunks<value_type>(
+        n, [in_ptr, &partial, &op](std::size_t chunk, std::size_t first, std::size_t last)
+        { partial[chunk] = std::reduce(in_ptr + first + 1, in_ptr + last, value_type(in_ptr[first]), op); });
+    std::inclusive_scan(partial.begin(), partial.begin() + n_chunks, partial.begin(), op);
+
+    parallel_for_chunks<value_type>(n, [in_ptr, out_ptr, &partial, &op](std::size_t chunk, std::size_t first, std::size_t last)
+                                    {
+                                        if (chunk == 0)
+                                        {
+                                            std::inclusive_scan(in_ptr + first, in_ptr + last, out_ptr + first, op);
+                                        }
+                                        else
+                                        {
+                                            std::inclusive_scan(in_ptr + first, in_ptr + last, out_ptr + first, op, partial[chunk - 1]);
+                                        } });
+}
+
+template <std::ranges::contiguous_range R1, std::ranges::contiguous_range R2>
+bool parallel_equal(R1 &&r1, R2 &&r2)
+{
+    if (std::ranges::size(r1) != std::ranges::size(r2))
+    {
+        return false;
+    }
+    const auto *ptr1 = std::ranges::data(r1);
+    const auto *ptr2 = std::ranges::data(r2);
+    std::vector<char> partial(ThreadPool::instance().size()); // Not std::vector<bool>, as it is written concurrently
+    const std::size_t n_chunks = parallel_for_chunks<std::ranges::range_value_t<R1>>(
+        std::ranges::size(r1), [ptr1, ptr2, &partial](std::size_t chunk, std::size_t first, std::size_t last)
+        { partial[chunk] = std::equal(ptr1 + first, ptr1 + last, ptr2 + first); });
+    return std::all_of(partial.begin(), partial.begin() + n_chunks, [](char e)
+                       { return e; });
+}
+
 void check_iterator_type_traits()
 {
     using T = int;
@@ -359,6 +1391,290 @@ void check_iterator_type_traits()
     static_assert(std::forward_iterator<DynamicArray<T>::iterator>, "Not ForwardIterator");
     static_assert(std::bidirectional_iterator<DynamicArray<T>::iterator>, "Not BiDirectionalIterator");
     static_assert(std::random_access_iterator<DynamicArray<T>::iterator>, "Not RandomAccessIterator");
+    static_assert(std::contiguous_iterator<DynamicArray<T>::iterator>, "Not ContiguousIterator");
+
+    static_assert(std::contiguous_iterator<DynamicArray<T>::const_iterator>, "Not ContiguousIterator");
+    static_assert(!std::output_iterator<DynamicArray<T>::const_iterator, T>, "const_iterator is OutputIterator");
+    static_assert(std::is_convertible_v<DynamicArray<T>::iterator, DynamicArray<T>::const_iterator>, "Not convertible to const_iterator");
+    static_assert(!std::is_convertible_v<DynamicArray<T>::const_iterator, DynamicArray<T>::iterator>, "const_iterator convertible to iterator");
+
+    static_assert(std::ranges::contiguous_range<DynamicArray<T>>, "Not contiguous range");
+    static_assert(std::ranges::contiguous_range<const DynamicArray<T>>, "Not contiguous range");
+    static_assert(std::ranges::contiguous_range<MappedArray<const T>>, "Not contiguous range");
+}
+
+// Prevent the compiler from optimizing away
+// the computation of value in a benchmark loop
+template <typename T>
+void do_not_optimize(T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Moving a DynamicArray must not depend on its size
+// Each array is moved back and forth n_moves times, and the average
+// time per move is reported for increasing array sizes
+void benchmark_move()
+{
+    static_assert(std::is_nothrow_move_constructible_v<DynamicArray<int>>, "Move constructor may throw");
+    static_assert(std::is_nothrow_move_assignable_v<DynamicArray<int>>, "Move assignment may throw");
+
+    constexpr std::size_t n_moves = 1'000'000;
+    for (std::size_t size = 10; size <= 10'000'000; size *= 10)
+    {
+        DynamicArray<int> a(size, 1);
+        DynamicArray<int> b;
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < n_moves; i += 2)
+        {
+            b = std::move(a);
+            do_not_optimize(b);
+            a = std::move(b);
+            do_not_optimize(a);
+        }
+        auto stop = std::chrono::steady_clock::now();
+
+        // Read the array afterwards, so that the moves are not optimized away
+        auto elapsed = std::chrono::duration<double, std::nano>(stop - start).count();
+        std::cout << std::format("size: {:>8}, move: {:.2f} ns, a[0]: {}\n", size, elapsed / n_moves, a[0]);
+    }
+
+    // Since the move constructor is noexcept, std::vector relocates
+    // its DynamicArrays by moving them, i.e. no element is copied
+    std::vector<DynamicArray<int>> queue;
+    for (int i = 0; i < 100; i++)
+    {
+        queue.push_back(DynamicArray<int>(1000, i));
+    }
+}
+
+// Compare the default allocation path (operator new) with the
+// memory resources, for many short-lived small arrays and for a large one
+void benchmark_allocators()
+{
+    // The arrays are created in batches, which are destroyed together
+    constexpr std::size_t n_batches = 1000;
+    constexpr std::size_t batch_size = 1000;
+    constexpr std::size_t small_size = 16;
+
+    auto time_small_arrays = [](const std::string &name, auto make_array, auto end_batch)
+    {
+        std::vector<decltype(make_array())> batch;
+        batch.reserve(batch_size);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < n_batches; i++)
+        {
+            for (std::size_t j = 0; j < batch_size; j++)
+            {
+                batch.push_back(make_array());
+                batch.back().push_back(static_cast<int>(j)); // Triggers a reallocation
+            }
+            do_not_optimize(batch.back()[small_size]);
+            batch.clear();
+            end_batch();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double, std::nano>(stop - start).count();
+        std::cout << std::format("{:<15}: {:.2f} ns per array\n", name, elapsed / (n_batches * batch_size));
+    };
+
+    time_small_arrays(
+        "operator new", []
+        { return DynamicArray<int>(small_size, 1); },
+        [] {});
+
+    std::pmr::unsynchronized_pool_resource pool;
+    time_small_arrays(
+        "pool", [&pool]
+        { return PmrDynamicArray<int>(small_size, 1, &pool); },
+        [] {});
+
+    // Deallocation is a no-op for the arena, so its memory
+    // is released in one go, once the batch is destroyed
+    std::pmr::monotonic_buffer_resource arena;
+    time_small_arrays(
+        "arena", [&arena]
+        { return PmrDynamicArray<int>(small_size, 1, &arena); },
+        [&arena]
+        { arena.release(); });
+
+    // Creating and traversing a large array is dominated by page faults
+    // and TLB misses, which huge pages reduce by a factor of 512
+    constexpr std::size_t large_size = std::size_t{256} * 1024 * 1024 / sizeof(int);
+
+    auto time_large_array = [](const std::string &name, auto make_array)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto a = make_array();
+        auto sum = std::accumulate(a.begin(), a.end(), std::size_t{0});
+        auto stop = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+        std::cout << std::format("{:<15}: {:.2f} ms (sum: {})\n", name, elapsed, sum);
+    };
+
+    time_large_array("operator new", []
+                     { return DynamicArray<int>(large_size, 1); });
+
+    HugePageResource huge_pages;
+    time_large_array("huge pages", [&huge_pages]
+                     { return PmrDynamicArray<int>(large_size, 1, &huge_pages); });
+}
+
+// Compare the time to create a large array filled with a value when
+// 1) the array is zeroed and then filled (two passes over memory)
+// 2) the array is filled on construction (single pass)
+// 3) the array is left uninitialized and then filled (single pass)
+// The bandwidth is computed from the bytes of the array, so that
+// the redundant pass of 1) shows up as a lower bandwidth
+void benchmark_initialization()
+{
+    constexpr std::size_t size = std::size_t{512} * 1024 * 1024 / sizeof(double);
+    constexpr double bytes = size * sizeof(double);
+
+    auto time_initialization = [](const std::string &name, auto make_array)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto a = make_array();
+        do_not_optimize(a[size - 1]);
+        auto stop = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double>(stop - start).count();
+        std::cout << std::format("{:<20}: {:.2f} ms, {:.2f} GB/s\n", name, elapsed * 1e3, bytes / elapsed * 1e-9);
+    };
+
+    time_initialization("zero, then fill", []
+                        { DynamicArray<double> a(size); std::fill(a.begin(), a.end(), 1.0); return a; });
+    time_initialization("fill", []
+                        { return DynamicArray<double>(size, 1.0); });
+    time_initialization("uninitialized, fill", []
+                        { DynamicArray<double> a(size, uninitialized); std::fill(a.begin(), a.end(), 1.0); return a; });
+}
+
+// Compare an element-by-element loop with the library algorithms
+// (std::copy, std::fill, std::equal) applied to the iterators of a
+// DynamicArray, and to the pointers obtained from them with std::to_address.
+// For pointers, the library uses memmove/memset/memcmp. Whether it does
+// the same for the iterators (i.e. uses the fact that they are contiguous)
+// depends on the implementation of the standard library: libstdc++ 12 does
+// not, and runs the generic element-by-element loop. Thus, only the rows
+// labeled memmove/memset/memcmp are known to take the fast path.
+void benchmark_contiguous_algorithms()
+{
+    constexpr std::size_t size = 64 * 1024 * 1024;
+    constexpr int n_repeats = 10;
+    DynamicArray<char> src(size, 'a');
+    DynamicArray<char> dst(size, 'b');
+
+    auto time_algorithm = [](const std::string &name, auto algorithm)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n_repeats; i++)
+        {
+            algorithm();
+        }
+        auto stop = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+        std::cout << std::format("{:<40}: {:.2f} ms\n", name, elapsed / n_repeats);
+    };
+
+    time_algorithm("copy (loop)", [&]
+                   { auto out = dst.begin(); for (auto it = src.cbegin(); it != src.cend(); ++it, ++out) *out = *it; do_not_optimize(dst); });
+    time_algorithm("copy (iterators, library-dependent)", [&]
+                   { std::copy(src.cbegin(), src.cend(), dst.begin()); do_not_optimize(dst); });
+    time_algorithm("copy (pointers, memmove)", [&]
+                   { std::copy(std::to_address(src.cbegin()), std::to_address(src.cend()), std::to_address(dst.begin())); do_not_optimize(dst); });
+
+    time_algorithm("fill (iterators, library-dependent)", [&]
+                   { std::fill(dst.begin(), dst.end(), 'c'); do_not_optimize(dst); });
+    time_algorithm("fill (pointers, memset)", [&]
+                   { std::fill(std::to_address(dst.begin()), std::to_address(dst.end()), 'c'); do_not_optimize(dst); });
+
+    // Equal arrays, so that std::equal has to compare all elements
+    dst = src;
+    bool equal = false;
+    time_algorithm("equal (iterators, library-dependent)", [&]
+                   { equal = std::equal(src.cbegin(), src.cend(), dst.cbegin()); do_not_optimize(equal); });
+    time_algorithm("equal (pointers, memcmp)", [&]
+                   { equal = std::equal(std::to_address(src.cbegin()), std::to_address(src.cend()), std::to_address(dst.cbegin())); do_not_optimize(equal); });
+}
+
+// Run the pipeline of main (iota, fill, inclusive_scan, equal) over large
+// arrays, once with the standard algorithms and once with the parallel ones
+void benchmark_parallel_algorithms()
+{
+    constexpr std::size_t size = 64 * 1024 * 1024;
+    DynamicArray<std::uint64_t> a(size, uninitialized);
+    DynamicArray<std::uint64_t> b(size, uninitialized);
+
+    auto time_pipeline = [](const std::string &name, auto pipeline)
+    {
+        auto start = std::chrono::steady_clock::now();
+        bool equal = pipeline();
+        auto stop = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+        std::cout << std::format("{:<22}: {:.2f} ms (equal: {})\n", name, elapsed, equal);
+    };
+
+    time_pipeline("serial", [&]
+                  {
+                    std::ranges::iota(a, 1);
+                    std::ranges::fill(b, 1);
+                    std::inclusive_scan(b.begin(), b.end(), b.begin());
+                    return std::ranges::equal(a, b); });
+
+    time_pipeline(std::format("parallel ({} threads)", ThreadPool::instance().size()), [&]
+                  {
+                    parallel_iota(a, std::uint64_t{1});
+                    parallel_fill(b, std::uint64_t{1});
+                    parallel_inclusive_scan(b, b);
+                    return parallel_equal(a, b); });
+
+    std::cout << std::format("sum: {}, {}\n", std::reduce(a.cbegin(), a.cend(), std::uint64_t{0}),
+                             parallel_reduce(a, std::uint64_t{0}));
+}
+
+// STREAM-like triad (a = b + s * c), computed in parallel over
+// arrays which are either initialized serially or in parallel
+// On a multi-socket (NUMA) system, serially initialized arrays reside on
+// the memory of a single socket, which limits the bandwidth of the triad.
+void benchmark_first_touch()
+{
+    constexpr std::size_t size = 32 * 1024 * 1024;
+    constexpr int n_repeats = 10;
+    constexpr double s = 3.0;
+
+    auto time_triad = [](const std::string &name, auto make_array)
+    {
+        auto a = make_array(0.0);
+        auto b = make_array(1.0);
+        auto c = make_array(2.0);
+
+        double *pa = a.data();
+        const double *pb = b.data();
+        const double *pc = c.data();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n_repeats; i++)
+        {
+            parallel_for<double>(size, [pa, pb, pc](std::size_t first, std::size_t last)
+                                 {
+                                    for (std::size_t j = first; j < last; j++)
+                                    {
+                                        pa[j] = pb[j] + s * pc[j];
+                                    } });
+        }
+        auto stop = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double>(stop - start).count();
+
+        // 2 arrays are read and 1 is written per iteration
+        const double bytes = 3.0 * size * sizeof(double) * n_repeats;
+        std::cout << std::format("{:<20}: {:.2f} GB/s (a[0]: {})\n", name, bytes / elapsed * 1e-9, a[0]);
+    };
+
+    time_triad("serial first-touch", [](double value)
+               { return DynamicArray<double>(size, value); });
+    time_triad("parallel first-touch", [](double value)
+               { return DynamicArray<double>(size, value, parallel_init); });
 }
 
 int main()
@@ -394,5 +1710,69 @@ int main()
         std::cout << e1 << " " << e2 << "\n";
     }
 
+    // Append to an empty DynamicArray one element at a time
+    // The capacity grows geometrically, so reallocations become rare
+    DynamicArray<uint> dyn_arr_3;
+    for (uint i = 1; i <= N; i++)
+    {
+        dyn_arr_3.push_back(i);
+        std::cout << std::format("size: {}, capacity: {}\n", dyn_arr_3.size(), dyn_arr_3.capacity());
+    }
+
+    // Cache-line aligned array
+    // The capacity is padded to a whole number of cache lines
+    AlignedDynamicArray<float> aligned_arr(N, 1.0f);
+    std::cout << std::format("size: {}, capacity: {}, address % {}: {}\n",
+                             aligned_arr.size(), aligned_arr.capacity(), aligned_arr.alignment(),
+                             reinterpret_cast<std::uintptr_t>(aligned_arr.data()) % aligned_arr.alignment());
+
+    // Write dyn_arr_1 to a binary file, and map it back into memory
+    // The mapped array can be used with the std::ranges algorithms, as is
+    const auto path = std::filesystem::temp_directory_path() / "dyn_arr_1.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(dyn_arr_1.data()), dyn_arr_1.size() * sizeof(uint));
+    }
+    {
+        MappedArray<const uint> mapped_arr(path);
+        mapped_arr.advise(MappedArray<const uint>::Advice::sequential);
+        std::cout << std::format("Mapped {} elements, max: {}, equal to dyn_arr_1: {}\n",
+                                 mapped_arr.size(), *std::ranges::max_element(mapped_arr),
+                                 std::ranges::equal(mapped_arr, dyn_arr_1));
+    }
+    std::filesystem::remove(path);
+
+    // Small array, which only allocates once it outgrows its inline storage
+    SmallDynamicArray<uint, 4> small_arr{1, 2, 3};
+    small_arr.push_back(4);
+    small_arr.push_back(5);
+    std::cout << std::format("size: {}, capacity: {}, sizeof: {}\n", small_arr.size(), small_arr.capacity(), sizeof(small_arr));
+
+    // Grow an array with copies of one of its own elements
+    // The copies are made before the old storage is released
+    DynamicArray<std::string> str_arr(3, std::string(32, 'a'));
+    str_arr.resize(4 * str_arr.capacity(), str_arr[0]);
+    std::cout << std::format("size: {}, all copies equal: {}\n", str_arr.size(),
+                             std::ranges::all_of(str_arr, [](const std::string &str)
+                                                 { return str == std::string(32, 'a'); }));
+
+    // Compare the cost of moving arrays of different sizes
+    benchmark_move();
+
+    // Compare the allocation strategies
+    benchmark_allocators();
+
+    // Compare single and double pass initialization
+    benchmark_initialization();
+
+    // Compare algorithms over iterators and pointers
+    benchmark_contiguous_algorithms();
+
+    // Compare the serial and parallel algorithms
+    benchmark_parallel_algorithms();
+
+    // Compare serial and parallel first-touch
+    benchmark_first_touch();
+
     return 0;
 }
\ No newline at end of file